@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ignis::bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline double secondsSince(Clock::time_point start) {
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct Result {
+	std::string name;
+	std::string unit;
+	double value{0.0};
+	uint64_t iterations{0};
+	std::vector<std::pair<std::string, double>> counters{};
+};
+
+// collects the results of a run and writes them as json
+class Report {
+public:
+	void add(Result result) { m_results.push_back(std::move(result)); }
+
+	void setContext(std::string key, std::string value) {
+		m_context.emplace_back(std::move(key), std::move(value));
+	}
+
+	void write(std::ostream& out) const {
+		out << "{\n  \"context\": {";
+
+		for (size_t i = 0; i < m_context.size(); i++) {
+			out << (i ? ", " : "") << '"' << m_context[i].first << "\": \""
+				<< m_context[i].second << '"';
+		}
+
+		out << "},\n  \"benchmarks\": [";
+
+		for (size_t i = 0; i < m_results.size(); i++) {
+			const auto& result = m_results[i];
+
+			out << (i ? ",\n" : "\n") << "    {\"name\": \"" << result.name
+				<< "\", \"unit\": \"" << result.unit
+				<< "\", \"value\": " << result.value
+				<< ", \"iterations\": " << result.iterations;
+
+			for (const auto& [counter, value] : result.counters) {
+				out << ", \"" << counter << "\": " << value;
+			}
+
+			out << "}";
+		}
+
+		out << "\n  ]\n}\n";
+	}
+
+private:
+	std::vector<std::pair<std::string, std::string>> m_context;
+	std::vector<Result> m_results;
+};
+
+}  // namespace ignis::bench
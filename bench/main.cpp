@@ -0,0 +1,582 @@
+#include <algorithm>
+#include <barrier>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "ignis/buffer.hpp"
+#include "ignis/command.hpp"
+#include "ignis/device.hpp"
+#include "ignis/image.hpp"
+#include "ignis/pipeline.hpp"
+#include "ignis/pipeline_compiler.hpp"
+#include "ignis/shader.hpp"
+#include "bench.hpp"
+#include "shaders.hpp"
+#include "vk_mem_alloc.h"
+
+// Headless GPU benchmarks, meant to run on any ICD (lavapipe included).
+// Usage: ignis_bench [--out results.json] [--scale N]
+
+using namespace ignis;
+using namespace ignis::bench;
+
+namespace {
+
+constexpr uint32_t RENDER_SIZE = 256;
+
+struct Context {
+	Device& device;
+	VkQueue queue;
+	uint32_t scale{1};
+};
+
+uint64_t submit(const Context& ctx, const Command& command) {
+	const Command* commands[]{&command};
+	SubmitInfo const submitInfo{.commands = commands};
+
+	return ctx.device.submitCommands({&submitInfo, 1});
+}
+
+void submitAndWait(const Context& ctx, const Command& command) {
+	ctx.device.waitForValue(ctx.queue, submit(ctx, command));
+}
+
+std::string formatSize(VkDeviceSize size) {
+	if (size >= 1024 * 1024) {
+		return std::to_string(size / (1024 * 1024)) + "MiB";
+	}
+
+	if (size >= 1024) {
+		return std::to_string(size / 1024) + "KiB";
+	}
+
+	return std::to_string(size) + "B";
+}
+
+// Command::updateBuffer into a device local buffer, staged through the ring
+void benchUpdateBuffer(const Context& ctx, Report& report) {
+	Command command({.device = ctx.device, .queue = ctx.queue});
+
+	for (VkDeviceSize size : {4 << 10, 64 << 10, 1 << 20, 16 << 20}) {
+		Buffer buffer(ctx.device.getAllocator(),
+					  {
+						  .bufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+										 VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+						  .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+						  .size = size,
+						  .initialData = nullptr,
+					  });
+
+		std::vector<uint8_t> data(size, 0xAB);
+
+		const uint64_t iterations =
+			std::max<uint64_t>(4, (256ull << 20) * ctx.scale / size / 16);
+
+		const auto start = Clock::now();
+
+		for (uint64_t i = 0; i < iterations; i++) {
+			command.begin();
+			command.updateBuffer(buffer, data.data(), 0,
+								 static_cast<uint32_t>(size));
+			command.end();
+			submitAndWait(ctx, command);
+		}
+
+		const double seconds = secondsSince(start);
+
+		report.add({
+			.name = "command_update_buffer/" + formatSize(size),
+			.unit = "MiB/s",
+			.value = static_cast<double>(size * iterations) / (1 << 20) / seconds,
+			.iterations = iterations,
+		});
+	}
+}
+
+// Buffer::writeData through the persistent mapping
+void benchWriteData(const Context& ctx, Report& report) {
+	for (VkDeviceSize size :
+		 {64, 256, 1 << 10, 4 << 10, 64 << 10, 1 << 20, 16 << 20}) {
+		Buffer buffer = ctx.device.createStagingBuffer(size);
+
+		std::vector<uint8_t> data(size, 0xCD);
+
+		const uint64_t iterations =
+			std::max<uint64_t>(16, (1ull << 30) * ctx.scale / size / 4);
+
+		const auto start = Clock::now();
+
+		for (uint64_t i = 0; i < iterations; i++) {
+			buffer.writeData(data.data(), 0, static_cast<uint32_t>(size));
+		}
+
+		const double seconds = secondsSince(start);
+
+		report.add({
+			.name = "buffer_write_data/" + formatSize(size),
+			.unit = "MiB/s",
+			.value = static_cast<double>(size * iterations) / (1 << 20) / seconds,
+			.iterations = iterations,
+		});
+	}
+}
+
+// the baseline of benchWriteData: mapping the memory around every write, the
+// allocation is dedicated so no other mapping keeps its block mapped
+void benchMapWriteUnmap(const Context& ctx, Report& report) {
+	VmaAllocator allocator = ctx.device.getAllocator();
+
+	for (VkDeviceSize size : {64, 256, 1 << 10, 4 << 10}) {
+		VkBufferCreateInfo const bufferInfo{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			.size = size,
+			.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		};
+
+		VmaAllocationCreateInfo const allocationInfo{
+			.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+					 VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT,
+			.usage = VMA_MEMORY_USAGE_AUTO,
+		};
+
+		VkBuffer buffer = nullptr;
+		VmaAllocation allocation = nullptr;
+
+		if (vmaCreateBuffer(allocator, &bufferInfo, &allocationInfo, &buffer,
+							&allocation, nullptr) != VK_SUCCESS) {
+			std::cerr << "failed to allocate the map baseline buffer" << std::endl;
+			return;
+		}
+
+		std::vector<uint8_t> data(size, 0xCD);
+
+		// a map per iteration, bounded independently of the size
+		const uint64_t iterations = (1ull << 16) * ctx.scale;
+
+		const auto start = Clock::now();
+
+		for (uint64_t i = 0; i < iterations; i++) {
+			void* mapped = nullptr;
+			vmaMapMemory(allocator, allocation, &mapped);
+			std::memcpy(mapped, data.data(), size);
+			vmaUnmapMemory(allocator, allocation);
+		}
+
+		const double seconds = secondsSince(start);
+
+		vmaDestroyBuffer(allocator, buffer, allocation);
+
+		report.add({
+			.name = "buffer_map_write_unmap/" + formatSize(size),
+			.unit = "MiB/s",
+			.value = static_cast<double>(size * iterations) / (1 << 20) / seconds,
+			.iterations = iterations,
+		});
+	}
+}
+
+// Command::updateImage of a whole RGBA8 image
+void benchUpdateImage(const Context& ctx, Report& report) {
+	Command command({.device = ctx.device, .queue = ctx.queue});
+
+	for (uint32_t extent : {64u, 256u, 1024u}) {
+		Image image = ctx.device.createDrawAttachmentImage({
+			.width = extent,
+			.height = extent,
+			.format = ColorFormat::RGBA8,
+		});
+
+		const VkDeviceSize size = image.getSize();
+
+		std::vector<uint8_t> pixels(size, 0x7F);
+
+		const uint64_t iterations =
+			std::max<uint64_t>(4, (128ull << 20) * ctx.scale / size / 16);
+
+		command.begin();
+		command.transitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		command.end();
+		submitAndWait(ctx, command);
+
+		const auto start = Clock::now();
+
+		for (uint64_t i = 0; i < iterations; i++) {
+			command.begin();
+			command.updateImage(image, pixels.data());
+			command.end();
+			submitAndWait(ctx, command);
+		}
+
+		const double seconds = secondsSince(start);
+
+		report.add({
+			.name = "command_update_image/" + std::to_string(extent) + "x" +
+					std::to_string(extent),
+			.unit = "MiB/s",
+			.value = static_cast<double>(size * iterations) / (1 << 20) / seconds,
+			.iterations = iterations,
+		});
+	}
+}
+
+std::unique_ptr<Pipeline> createPipeline(
+	const Context& ctx,
+	Shader& vertex,
+	Shader& fragment,
+	VkCullModeFlags cullMode = VK_CULL_MODE_NONE) {
+	return std::make_unique<Pipeline>(PipelineCreateInfo{
+		.device = &ctx.device,
+		.shaders = {&vertex, &fragment},
+		.colorFormat = ColorFormat::RGBA8,
+		.cullMode = cullMode,
+	});
+}
+
+// bindPipeline + draw pairs recorded per second, CPU side only; the binds
+// alternate between two pipelines so none is dropped by the state cache, the
+// elided entry rebinds the same one
+void benchRecordDraws(const Context& ctx, Report& report) {
+	Shader vertex = ctx.device.createShader(VERTEX_SHADER, sizeof(VERTEX_SHADER),
+											VK_SHADER_STAGE_VERTEX_BIT);
+	Shader fragment = ctx.device.createShader(
+		FRAGMENT_SHADER, sizeof(FRAGMENT_SHADER), VK_SHADER_STAGE_FRAGMENT_BIT);
+
+	auto pipeline = createPipeline(ctx, vertex, fragment);
+	auto otherPipeline =
+		createPipeline(ctx, vertex, fragment, VK_CULL_MODE_BACK_BIT);
+
+	Image drawImage = ctx.device.createDrawAttachmentImage({
+		.width = RENDER_SIZE,
+		.height = RENDER_SIZE,
+		.format = ColorFormat::RGBA8,
+	});
+
+	const uint32_t indices[3]{0, 1, 2};
+	Buffer indexBuffer = ctx.device.createIndexBuffer32(3, indices);
+
+	Command command({.device = ctx.device, .queue = ctx.queue});
+
+	const uint32_t drawsPerCommand = 10000;
+	const uint64_t iterations = 20ull * ctx.scale;
+
+	DrawAttachment const drawAttachment{.drawImage = &drawImage};
+
+	const uint64_t draws = drawsPerCommand * iterations;
+
+	for (const bool alternate : {true, false}) {
+		const Pipeline* pipelines[2]{
+			pipeline.get(), alternate ? otherPipeline.get() : pipeline.get()};
+
+		double recordSeconds{0.0};
+		uint64_t elidedBinds{0};
+
+		for (uint64_t i = 0; i < iterations; i++) {
+			command.begin();
+			command.transitionToOptimalLayout(drawImage);
+			command.beginRender(&drawAttachment, nullptr);
+			command.setViewport({0, 0, RENDER_SIZE, RENDER_SIZE, 0, 1});
+			command.setScissor(RENDER_SIZE, RENDER_SIZE);
+			command.bindIndexBuffer(indexBuffer);
+
+			const auto start = Clock::now();
+
+			for (uint32_t draw = 0; draw < drawsPerCommand; draw++) {
+				command.bindPipeline(*pipelines[draw % 2]);
+				command.draw(3);
+			}
+
+			recordSeconds += secondsSince(start);
+
+			elidedBinds += command.getElidedCalls().pipelines;
+
+			command.endRendering();
+			command.end();
+			submitAndWait(ctx, command);
+		}
+
+		report.add({
+			.name = alternate ? "record_bind_pipeline_draw"
+							  : "record_bind_pipeline_draw/elided",
+			.unit = "draws/s",
+			.value = static_cast<double>(draws) / recordSeconds,
+			.iterations = draws,
+			.counters = {{"elided_binds_per_draw",
+						  static_cast<double>(elidedBinds) /
+							  static_cast<double>(draws)}},
+		});
+	}
+}
+
+// one render split in secondary commands recorded on several threads, each
+// with its own pools
+void benchRecordParallel(const Context& ctx, Report& report) {
+	Shader vertex = ctx.device.createShader(VERTEX_SHADER, sizeof(VERTEX_SHADER),
+											VK_SHADER_STAGE_VERTEX_BIT);
+	Shader fragment = ctx.device.createShader(
+		FRAGMENT_SHADER, sizeof(FRAGMENT_SHADER), VK_SHADER_STAGE_FRAGMENT_BIT);
+
+	auto pipeline = createPipeline(ctx, vertex, fragment);
+	auto otherPipeline =
+		createPipeline(ctx, vertex, fragment, VK_CULL_MODE_BACK_BIT);
+
+	// alternated so the state cache doesn't drop the binds
+	const Pipeline* pipelines[2]{pipeline.get(), otherPipeline.get()};
+
+	Image drawImage = ctx.device.createDrawAttachmentImage({
+		.width = RENDER_SIZE,
+		.height = RENDER_SIZE,
+		.format = ColorFormat::RGBA8,
+	});
+
+	const uint32_t indices[3]{0, 1, 2};
+	Buffer indexBuffer = ctx.device.createIndexBuffer32(3, indices);
+
+	Command command({.device = ctx.device, .queue = ctx.queue});
+
+	const uint32_t threadCount =
+		std::clamp(std::thread::hardware_concurrency(), 1u, 16u);
+	const uint32_t drawsPerThread = 10000;
+	const uint64_t iterations = 10ull * ctx.scale;
+
+	DrawAttachment const drawAttachment{.drawImage = &drawImage};
+
+	std::vector<const Command*> secondaries(threadCount);
+
+	// workers record between the two barriers, the main thread submits after
+	std::barrier recordStart(threadCount + 1);
+	std::barrier recordEnd(threadCount + 1);
+
+	auto record = [&](uint32_t thread) {
+		Command secondary({
+			.device = ctx.device,
+			.queue = ctx.queue,
+			.commandPool = ctx.device.acquireCommandPool(ctx.queue),
+			.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+		});
+
+		secondaries[thread] = &secondary;
+
+		for (uint64_t i = 0; i < iterations; i++) {
+			recordStart.arrive_and_wait();
+
+			// the previous submission has completed
+			ctx.device.resetCommandPools();
+
+			secondary.beginSecondary(&drawAttachment, nullptr);
+			secondary.bindPipeline(*pipeline);
+			secondary.setViewport({0, 0, RENDER_SIZE, RENDER_SIZE, 0, 1});
+			secondary.setScissor(RENDER_SIZE, RENDER_SIZE);
+			secondary.bindIndexBuffer(indexBuffer);
+
+			for (uint32_t draw = 0; draw < drawsPerThread; draw++) {
+				secondary.bindPipeline(*pipelines[draw % 2]);
+				secondary.draw(3);
+			}
+
+			secondary.end();
+
+			recordEnd.arrive_and_wait();
+		}
+
+		// the last submission has been waited before the final barrier
+		recordStart.arrive_and_wait();
+	};
+
+	std::vector<std::thread> threads;
+
+	for (uint32_t i = 0; i < threadCount; i++) {
+		threads.emplace_back(record, i);
+	}
+
+	double recordSeconds{0.0};
+
+	for (uint64_t i = 0; i < iterations; i++) {
+		const auto start = Clock::now();
+
+		recordStart.arrive_and_wait();
+		recordEnd.arrive_and_wait();
+
+		recordSeconds += secondsSince(start);
+
+		command.begin();
+		command.transitionToOptimalLayout(drawImage);
+		command.beginRender(&drawAttachment, nullptr,
+							VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT);
+		command.executeSecondary(secondaries);
+		command.endRendering();
+		command.end();
+		submitAndWait(ctx, command);
+	}
+
+	recordStart.arrive_and_wait();
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	const uint64_t draws = uint64_t{drawsPerThread} * threadCount * iterations;
+
+	report.add({
+		.name = "record_parallel/" + std::to_string(threadCount) + "_threads",
+		.unit = "draws/s",
+		.value = static_cast<double>(draws) / recordSeconds,
+		.iterations = draws,
+	});
+}
+
+// submission of an empty command until its timeline value is reached
+void benchSubmitLatency(const Context& ctx, Report& report) {
+	Command command({.device = ctx.device, .queue = ctx.queue});
+
+	const uint64_t iterations = 1000ull * ctx.scale;
+
+	std::vector<double> submitUs;
+	std::vector<double> roundTripUs;
+	submitUs.reserve(iterations);
+	roundTripUs.reserve(iterations);
+
+	for (uint64_t i = 0; i < iterations; i++) {
+		command.begin();
+		command.end();
+
+		const auto start = Clock::now();
+
+		const uint64_t value = submit(ctx, command);
+
+		submitUs.push_back(secondsSince(start) * 1e6);
+
+		ctx.device.waitForValue(ctx.queue, value);
+
+		roundTripUs.push_back(secondsSince(start) * 1e6);
+	}
+
+	auto percentile = [](std::vector<double> values, double p) {
+		std::sort(values.begin(), values.end());
+		const auto last = static_cast<double>(values.size() - 1);
+		return values[static_cast<size_t>(p * last)];
+	};
+
+	report.add({"submit_commands/p50", "us", percentile(submitUs, 0.5),
+				iterations});
+	report.add({"submit_commands/p99", "us", percentile(submitUs, 0.99),
+				iterations});
+	report.add({"submit_round_trip/p50", "us", percentile(roundTripUs, 0.5),
+				iterations});
+	report.add({"submit_round_trip/p99", "us", percentile(roundTripUs, 0.99),
+				iterations});
+}
+
+void benchPipelineCreation(const Context& ctx, Report& report) {
+	Shader vertex = ctx.device.createShader(VERTEX_SHADER, sizeof(VERTEX_SHADER),
+											VK_SHADER_STAGE_VERTEX_BIT);
+	Shader fragment = ctx.device.createShader(
+		FRAGMENT_SHADER, sizeof(FRAGMENT_SHADER), VK_SHADER_STAGE_FRAGMENT_BIT);
+
+	const uint64_t iterations = 50ull * ctx.scale;
+
+	const auto start = Clock::now();
+
+	for (uint64_t i = 0; i < iterations; i++) {
+		auto pipeline = createPipeline(ctx, vertex, fragment);
+	}
+
+	report.add({
+		.name = "pipeline_creation",
+		.unit = "ms",
+		.value = secondsSince(start) * 1e3 / static_cast<double>(iterations),
+		.iterations = iterations,
+	});
+}
+
+// the same pipelines as above, compiled on the worker pool
+void benchPipelineCompiler(const Context& ctx, Report& report) {
+	Shader vertex = ctx.device.createShader(VERTEX_SHADER, sizeof(VERTEX_SHADER),
+											VK_SHADER_STAGE_VERTEX_BIT);
+	Shader fragment = ctx.device.createShader(
+		FRAGMENT_SHADER, sizeof(FRAGMENT_SHADER), VK_SHADER_STAGE_FRAGMENT_BIT);
+
+	PipelineCompiler compiler({.device = ctx.device});
+
+	const uint64_t iterations = 50ull * ctx.scale;
+
+	std::vector<PipelineCreateInfo> infos(iterations,
+										  {
+											  .device = &ctx.device,
+											  .shaders = {&vertex, &fragment},
+											  .colorFormat = ColorFormat::RGBA8,
+											  .cullMode = VK_CULL_MODE_NONE,
+										  });
+
+	const auto start = Clock::now();
+
+	auto pipelines = compiler.compile(infos);
+	compiler.waitIdle();
+
+	report.add({
+		.name = "pipeline_compiler/" + std::to_string(compiler.getThreadCount()) +
+				"_threads",
+		.unit = "ms",
+		.value = secondsSince(start) * 1e3 / static_cast<double>(iterations),
+		.iterations = iterations,
+	});
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	std::string outPath;
+	uint32_t scale{1};
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+			outPath = argv[++i];
+		} else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+			scale = std::max(1, atoi(argv[++i]));
+		} else {
+			std::cerr << "usage: ignis_bench [--out results.json] [--scale N]"
+					  << std::endl;
+			return 1;
+		}
+	}
+
+	Device device({.appName = "ignis_bench"});
+
+	const Context ctx{
+		.device = device,
+		.queue = device.getQueue(0),
+		.scale = scale,
+	};
+
+	Report report;
+	report.setContext("device", device.getPhysicalDeviceProperties().deviceName);
+
+	benchWriteData(ctx, report);
+	benchMapWriteUnmap(ctx, report);
+	benchUpdateBuffer(ctx, report);
+	benchUpdateImage(ctx, report);
+	benchRecordDraws(ctx, report);
+	benchRecordParallel(ctx, report);
+	benchSubmitLatency(ctx, report);
+	benchPipelineCreation(ctx, report);
+	benchPipelineCompiler(ctx, report);
+
+	if (outPath.empty()) {
+		report.write(std::cout);
+		return 0;
+	}
+
+	std::ofstream file(outPath);
+
+	if (!file.is_open()) {
+		std::cerr << "failed to open " << outPath << std::endl;
+		return 1;
+	}
+
+	report.write(file);
+
+	return 0;
+}
@@ -0,0 +1,336 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include "ignis/buffer.hpp"
+#include "ignis/command.hpp"
+#include "ignis/command_pool.hpp"
+#include "ignis/device.hpp"
+#include "ignis/image.hpp"
+#include "ignis/pipeline.hpp"
+#include "ignis/shader.hpp"
+#include "micro.hpp"
+#include "shaders.hpp"
+
+// CPU cost of the record and submit paths, one API call per iteration.
+// Usage: ignis_microbench [--out results.json] [--min-time seconds]
+
+std::atomic<uint64_t> ignis::bench::g_allocationCount{0};
+
+void* operator new(size_t size) {
+	ignis::bench::g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (void* ptr = std::malloc(size != 0 ? size : 1)) {
+		return ptr;
+	}
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+using namespace ignis;
+using namespace ignis::bench;
+
+namespace {
+
+// commands are re-begun after this many calls so the command buffer memory
+// stays bounded; the cost is amortized over the batch
+constexpr uint64_t CALLS_PER_RECORDING = 1 << 16;
+
+struct PushData {
+	float values[4];
+};
+
+struct Fixture {
+	Fixture()
+		: device({.appName = "ignis_microbench"}),
+		  vertex(device.createShader(VERTEX_SHADER,
+									 sizeof(VERTEX_SHADER),
+									 VK_SHADER_STAGE_VERTEX_BIT)),
+		  fragment(device.createShader(FRAGMENT_SHADER,
+									   sizeof(FRAGMENT_SHADER),
+									   VK_SHADER_STAGE_FRAGMENT_BIT)),
+		  pipeline({
+			  .device = &device,
+			  .shaders = {&vertex, &fragment},
+			  .colorFormat = ColorFormat::RGBA8,
+			  .cullMode = VK_CULL_MODE_NONE,
+		  }),
+		  otherPipeline({
+			  .device = &device,
+			  .shaders = {&vertex, &fragment},
+			  .colorFormat = ColorFormat::RGBA8,
+			  .cullMode = VK_CULL_MODE_BACK_BIT,
+		  }),
+		  image(device.createDrawAttachmentImage({
+			  .width = 64,
+			  .height = 64,
+			  .format = ColorFormat::RGBA8,
+		  })),
+		  command({.device = device, .queue = device.getQueue(0)}),
+		  buffer(device.createSSBO(256)) {}
+
+	~Fixture() { device.waitIdle(); }
+
+	// re-begins the command every CALLS_PER_RECORDING calls
+	template <typename Fn>
+	void record(uint64_t iterations, Fn&& fn) {
+		uint64_t i = 0;
+
+		while (i < iterations) {
+			command.begin(0);
+			command.bindPipeline(pipeline);
+
+			const uint64_t end = std::min(iterations, i + CALLS_PER_RECORDING);
+
+			for (; i < end; i++) {
+				fn();
+			}
+
+			command.end();
+		}
+	}
+
+	Device device;
+	Shader vertex;
+	Shader fragment;
+	Pipeline pipeline;
+	Pipeline otherPipeline;	 // same layout, binds alternate with pipeline
+	Image image;
+	Command command;
+	BufferId buffer;
+};
+
+// the payloads alternate so every push is recorded, the elided entry repeats
+// the same one and measures the state cache hit
+void benchPushConstants(Fixture& fixture, Report& report, double minSeconds) {
+	PushData const data[2]{{1.0f, 2.0f, 3.0f, 4.0f}, {4.0f, 3.0f, 2.0f, 1.0f}};
+
+	uint64_t call{0};
+
+	runMicro(
+		report, "command_push_constants",
+		[&](uint64_t iterations) {
+			fixture.record(iterations, [&] {
+				fixture.command.pushConstants(fixture.pipeline, data[call++ % 2]);
+			});
+		},
+		minSeconds);
+
+	runMicro(
+		report, "command_push_constants/elided",
+		[&](uint64_t iterations) {
+			fixture.record(iterations, [&] {
+				fixture.command.pushConstants(fixture.pipeline, data[0]);
+			});
+		},
+		minSeconds);
+}
+
+void benchBindPipeline(Fixture& fixture, Report& report, double minSeconds) {
+	const Pipeline* pipelines[2]{&fixture.otherPipeline, &fixture.pipeline};
+
+	uint64_t call{0};
+
+	runMicro(
+		report, "command_bind_pipeline",
+		[&](uint64_t iterations) {
+			fixture.record(iterations, [&] {
+				fixture.command.bindPipeline(*pipelines[call++ % 2]);
+			});
+		},
+		minSeconds);
+
+	runMicro(
+		report, "command_bind_pipeline/elided",
+		[&](uint64_t iterations) {
+			fixture.record(iterations,
+						   [&] { fixture.command.bindPipeline(fixture.pipeline); });
+		},
+		minSeconds);
+}
+
+void benchTransitionImageLayout(Fixture& fixture,
+								Report& report,
+								double minSeconds) {
+	bool toTransfer{true};
+
+	runMicro(
+		report, "command_transition_image_layout",
+		[&](uint64_t iterations) {
+			fixture.record(iterations, [&] {
+				fixture.command.transitionImageLayout(
+					fixture.image, toTransfer
+									   ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+									   : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+				toTransfer = !toTransfer;
+			});
+		},
+		minSeconds);
+}
+
+void benchGetBuffer(Fixture& fixture, Report& report, double minSeconds) {
+	runMicro(
+		report, "device_get_buffer",
+		[&](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				doNotOptimize(fixture.device.getBuffer(fixture.buffer).getHandle());
+			}
+		},
+		minSeconds);
+}
+
+void benchSubmitCommands(Fixture& fixture, Report& report, double minSeconds) {
+	Command& command = fixture.command;
+	const VkQueue queue = command.getQueue();
+
+	// the same empty command is submitted over and over
+	command.begin(VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+	command.end();
+
+	const Command* commands[]{&command};
+	SubmitInfo const submitInfo{.commands = commands};
+
+	runMicro(
+		report, "device_submit_commands",
+		[&](uint64_t iterations) {
+			uint64_t value{0};
+
+			for (uint64_t i = 0; i < iterations; i++) {
+				value = fixture.device.submitCommands({&submitInfo, 1});
+
+				// bound the queue depth, amortized like the re-begin above
+				if ((i + 1) % 1024 == 0) {
+					fixture.device.waitForValue(queue, value);
+				}
+			}
+
+			fixture.device.waitForValue(queue, value);
+		},
+		minSeconds);
+}
+
+// a lookup of a pipeline that is already alive
+void benchGetOrCreatePipeline(Fixture& fixture, Report& report, double minSeconds) {
+	PipelineCreateInfo const info{
+		.device = &fixture.device,
+		.shaders = {&fixture.vertex, &fixture.fragment},
+		.colorFormat = ColorFormat::RGBA8,
+		.cullMode = VK_CULL_MODE_NONE,
+	};
+
+	auto pipeline = fixture.device.getOrCreatePipeline(info);
+
+	runMicro(
+		report, "device_get_or_create_pipeline",
+		[&](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				doNotOptimize(fixture.device.getOrCreatePipeline(info).get());
+			}
+		},
+		minSeconds);
+}
+
+// one-shot commands: a dedicated allocation each, against a pooled block
+void benchCommandAllocation(Fixture& fixture, Report& report, double minSeconds) {
+	const VkQueue queue = fixture.command.getQueue();
+
+	runMicro(
+		report, "command_create_destroy",
+		[&](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				Command command({.device = fixture.device, .queue = queue});
+				doNotOptimize(command.getHandle());
+			}
+		},
+		minSeconds);
+
+	CommandPool pool({.device = fixture.device, .queue = queue});
+
+	runMicro(
+		report, "command_pool_acquire",
+		[&](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				doNotOptimize(pool.acquire().getHandle());
+
+				// a reset per frame of 64 commands
+				if ((i + 1) % 64 == 0) {
+					pool.reset();
+				}
+			}
+
+			pool.reset();
+		},
+		minSeconds);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	std::string outPath;
+	double minSeconds{0.5};
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+			outPath = argv[++i];
+		} else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+			minSeconds = std::max(0.01, atof(argv[++i]));
+		} else {
+			std::cerr << "usage: ignis_microbench [--out results.json] "
+						 "[--min-time seconds]"
+					  << std::endl;
+			return 1;
+		}
+	}
+
+	Fixture fixture;
+
+	Report report;
+	report.setContext("device",
+					  fixture.device.getPhysicalDeviceProperties().deviceName);
+	report.setContext("perf_counters", PerfCounter().isAvailable() ? "yes" : "no");
+
+	benchPushConstants(fixture, report, minSeconds);
+	benchBindPipeline(fixture, report, minSeconds);
+	benchTransitionImageLayout(fixture, report, minSeconds);
+	benchGetBuffer(fixture, report, minSeconds);
+	benchSubmitCommands(fixture, report, minSeconds);
+	benchCommandAllocation(fixture, report, minSeconds);
+	benchGetOrCreatePipeline(fixture, report, minSeconds);
+
+	if (outPath.empty()) {
+		report.write(std::cout);
+		return 0;
+	}
+
+	std::ofstream file(outPath);
+
+	if (!file.is_open()) {
+		std::cerr << "failed to open " << outPath << std::endl;
+		return 1;
+	}
+
+	report.write(file);
+
+	return 0;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include "bench.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// A minimal Google Benchmark style harness: every benchmark is a function that
+// runs a given number of iterations; the harness grows the count until a run
+// takes long enough, then reports ns, allocations and cache misses per call.
+
+namespace ignis::bench {
+
+// incremented by the global operator new of the microbenchmark executable
+extern std::atomic<uint64_t> g_allocationCount;
+
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const T* sink;
+	sink = &value;
+#endif
+}
+
+// hardware cache misses of the calling thread, when perf events are available
+class PerfCounter {
+public:
+	PerfCounter() {
+#ifdef __linux__
+		perf_event_attr attr{};
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+
+	~PerfCounter() {
+#ifdef __linux__
+		if (m_fd >= 0) {
+			close(m_fd);
+		}
+#endif
+	}
+
+	bool isAvailable() const { return m_fd >= 0; }
+
+	void start() {
+#ifdef __linux__
+		if (m_fd >= 0) {
+			ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	std::optional<uint64_t> stop() {
+#ifdef __linux__
+		if (m_fd >= 0) {
+			ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+
+			uint64_t count{0};
+			if (read(m_fd, &count, sizeof(count)) == sizeof(count)) {
+				return count;
+			}
+		}
+#endif
+		return std::nullopt;
+	}
+
+private:
+	int m_fd{-1};
+
+public:
+	PerfCounter(const PerfCounter&) = delete;
+	PerfCounter& operator=(const PerfCounter&) = delete;
+};
+
+template <typename Fn>
+void runMicro(Report& report, const char* name, Fn&& fn, double minSeconds) {
+	PerfCounter perf;
+
+	// warm up caches and lazily created state
+	fn(uint64_t{1});
+
+	uint64_t iterations{1};
+
+	while (true) {
+		const uint64_t allocations = g_allocationCount.load();
+
+		perf.start();
+		const auto start = Clock::now();
+
+		fn(iterations);
+
+		const double seconds = secondsSince(start);
+		const auto cacheMisses = perf.stop();
+
+		if (seconds < minSeconds && iterations < (uint64_t{1} << 32)) {
+			const double target = minSeconds / std::max(seconds, 1e-9) * 1.2;
+			iterations = std::max(iterations * 2,
+								  static_cast<uint64_t>(iterations * target));
+			iterations = std::min(iterations, uint64_t{1} << 32);
+			continue;
+		}
+
+		const auto calls = static_cast<double>(iterations);
+
+		Result result{
+			.name = name,
+			.unit = "ns",
+			.value = seconds * 1e9 / calls,
+			.iterations = iterations,
+		};
+
+		result.counters.emplace_back(
+			"allocs_per_call",
+			static_cast<double>(g_allocationCount.load() - allocations) / calls);
+
+		if (cacheMisses) {
+			result.counters.emplace_back("cache_misses_per_call",
+										 static_cast<double>(*cacheMisses) / calls);
+		}
+
+		report.add(std::move(result));
+		return;
+	}
+}
+
+}  // namespace ignis::bench
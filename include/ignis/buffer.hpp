@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vulkan/vulkan_core.h>
+#include <cassert>
+#include <span>
 
 struct VmaAllocator_T;
 struct VmaAllocation_T;
@@ -12,6 +14,9 @@ struct BufferCreateInfo {
 	VkMemoryPropertyFlags memoryProperties;
 	VkDeviceSize size;
 	const void* initialData;
+	// allow device local memory to be host visible when the device supports it
+	// (integrated GPUs, resizable BAR), so the buffer can be written directly
+	bool allowHostAccess{false};
 };
 
 class Buffer {
@@ -26,10 +31,31 @@ public:
 
 	auto getUsage() const { return m_bufferUsage; }
 
+	auto getMemoryProperties() const { return m_memoryProperties; }
+
+	// stable for the whole lifetime of the buffer, nullptr if not host visible
+	void* getMappedPointer() const { return m_mappedData; }
+
+	bool isHostVisible() const { return m_mappedData != nullptr; }
+
+	template <typename T>
+	std::span<T> getMappedSpan() const {
+		assert(m_mappedData != nullptr && "Buffer is not host visible");
+		return {static_cast<T*>(m_mappedData), m_size / sizeof(T)};
+	}
+
 public:
-	void writeData(const void* data, VkDeviceSize offset = 0, uint32_t size = 0);
+	void writeData(const void* data,
+				   VkDeviceSize offset = 0,
+				   uint32_t size = 0) const;
+
+	void readData(void* data, VkDeviceSize offset = 0, uint32_t size = 0) const;
+
+	// needed only after writing/reading through the mapped pointer on non
+	// coherent memory; they are no-ops otherwise
+	void flush(VkDeviceSize offset = 0, VkDeviceSize size = 0) const;
 
-	void readData(void* data, VkDeviceSize offset = 0, uint32_t size = 0);
+	void invalidate(VkDeviceSize offset = 0, VkDeviceSize size = 0) const;
 
 	VkDeviceAddress getDeviceAddress(VkDevice) const;
 
@@ -59,6 +85,7 @@ private:
 	VkBufferUsageFlags m_bufferUsage;
 	VkBuffer m_buffer{nullptr};
 	VkMemoryPropertyFlags m_memoryProperties;
+	void* m_mappedData{nullptr};
 
 public:
 	Buffer(Buffer&& other) noexcept;
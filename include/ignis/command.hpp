@@ -1,7 +1,9 @@
 #pragma once
 
+#include <array>
 #include <cassert>
 #include <memory>
+#include <span>
 #include "vulkan/vulkan_core.h"
 #include "pipeline.hpp"
 #include "device.hpp"
@@ -11,6 +13,9 @@ namespace ignis {
 class Buffer;
 class Image;
 class Pipeline;
+class ComputePipeline;
+class GpuProfiler;
+class CommandPool;
 
 struct DrawAttachment {
 	Image* drawImage{nullptr};
@@ -28,6 +33,21 @@ struct DepthAttachment {
 struct CommandCreateInfo {
 	const Device& device;
 	VkQueue queue;
+	// defaults to the shared pool of the queue; a command allocated from
+	// Device::acquireCommandPool must be recorded and destroyed on the thread
+	// that acquired the pool
+	VkCommandPool commandPool{nullptr};
+	VkCommandBufferLevel level{VK_COMMAND_BUFFER_LEVEL_PRIMARY};
+};
+
+// calls dropped by the state cache since the command was begun
+struct ElidedCalls {
+	uint32_t pipelines{0};
+	uint32_t descriptorSets{0};
+	uint32_t indexBuffers{0};
+	uint32_t viewports{0};
+	uint32_t scissors{0};
+	uint32_t pushConstants{0};
 };
 
 #define CHECK_IS_RECORDING \
@@ -35,28 +55,74 @@ struct CommandCreateInfo {
 
 #define CHECK_PIPELINE_BOUND assert(m_pipelineBound && "Pipeline is not bound!");
 
-// Note 1: every command is a graphics command
-// Note 2: every command is primary
-// Note 3: allocation, deallocation and resetting is per-command, not per-pool, i.e.
-// we can't batch those operations for multiple commands
+#define CHECK_COMPUTE_PIPELINE_BOUND \
+	assert(m_computePipelineBound && "Pipeline is not bound!");
+
+// Note 1: commands on graphics queues can record both draws and dispatches,
+// commands on compute queues (Device::getComputeQueue) can't render
+// Note 2: a secondary command can only be recorded inside a render, it is
+// begun with the attachments of the render that executes it; its staging
+// regions are released when it is re-recorded, so it must not be re-recorded
+// before the primary commands executing it have completed
+// Note 3: a command allocates and frees its own command buffer, unless it is
+// acquired from a CommandPool, which allocates them in blocks and resets them
+// all at once
 // Note 4: every draw command is indexed
 // Note 5: clear values are fixed
 // Note 6: the render area is fixed
 // Note 7: we can only render to 1 draw attachment
+// Note 8: binds, dynamic state and push constants equal to the ones already
+// recorded are dropped; the cache is cleared on begin and after
+// executeSecondary, state recorded directly on the handle must be followed by
+// invalidateState
 
 class Command {
+	friend class CommandPool;
+	friend class Device;
+
 public:
 	Command(const CommandCreateInfo&);
 	~Command();
 
+	// writes a timestamp at the start and at the end of its scope
+	class ProfileZone {
+	public:
+		ProfileZone(Command&, GpuProfiler&, const char* name);
+		~ProfileZone();
+
+	private:
+		Command& m_command;
+		GpuProfiler& m_profiler;
+		uint32_t m_zone;
+
+	public:
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone(ProfileZone&&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+		ProfileZone& operator=(ProfileZone&&) = delete;
+	};
+
 	void begin(VkCommandBufferUsageFlags flags =
 				   VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
+	// secondary commands only; the attachments must match the ones passed to
+	// the beginRender of the executing command
+	void beginSecondary(const DrawAttachment*,
+						const DepthAttachment*,
+						VkCommandBufferUsageFlags flags =
+							VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
 	void end();
 
 	void bindPipeline(const Pipeline&);
 
-	void beginRender(const DrawAttachment*, const DepthAttachment*);
+	void bindPipeline(const ComputePipeline&);
+
+	// pass VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT to record the
+	// render with executeSecondary only
+	void beginRender(const DrawAttachment*,
+					 const DepthAttachment*,
+					 VkRenderingFlags flags = 0);
 
 	void endRendering();
 
@@ -67,15 +133,87 @@ public:
 		CHECK_IS_RECORDING;
 		CHECK_PIPELINE_BOUND;
 
-		auto pipelineLayout = pipeline.getLayoutHandle();
+		static_assert(sizeof(T) % 4 == 0, "Push constants are made of words");
+
+		pushConstantData(pipeline.getLayoutHandle(), &data, offset, sizeof(T));
+	}
 
-		vkCmdPushConstants(m_commandBuffer, pipelineLayout, VK_SHADER_STAGE_ALL,
-						   offset, sizeof(T), &data);
+	template <typename T>
+	void pushConstants(const ComputePipeline& pipeline,
+					   const T& data,
+					   uint32_t offset = 0) {
+		CHECK_IS_RECORDING;
+		CHECK_COMPUTE_PIPELINE_BOUND;
+
+		static_assert(sizeof(T) % 4 == 0, "Push constants are made of words");
+
+		pushConstantData(pipeline.getLayoutHandle(), &data, offset, sizeof(T));
 	}
 
 	void transitionImageLayout(Image&, VkImageLayout);
 	void transitionToOptimalLayout(Image&);
 
+	// execution and memory dependencies without layout transitions, e.g.
+	// between a dispatch writing a buffer and a draw reading it
+	void memoryBarrier(VkPipelineStageFlags2 srcStage,
+					   VkAccessFlags2 srcAccess,
+					   VkPipelineStageFlags2 dstStage,
+					   VkAccessFlags2 dstAccess);
+
+	void bufferBarrier(const Buffer&,
+					   VkPipelineStageFlags2 srcStage,
+					   VkAccessFlags2 srcAccess,
+					   VkPipelineStageFlags2 dstStage,
+					   VkAccessFlags2 dstAccess,
+					   VkDeviceSize offset = 0,
+					   VkDeviceSize size = VK_WHOLE_SIZE);
+
+	void bufferBarrier(BufferId,
+					   VkPipelineStageFlags2 srcStage,
+					   VkAccessFlags2 srcAccess,
+					   VkPipelineStageFlags2 dstStage,
+					   VkAccessFlags2 dstAccess,
+					   VkDeviceSize offset = 0,
+					   VkDeviceSize size = VK_WHOLE_SIZE);
+
+	// the image stays in its current layout
+	void imageBarrier(const Image&,
+					  VkPipelineStageFlags2 srcStage,
+					  VkAccessFlags2 srcAccess,
+					  VkPipelineStageFlags2 dstStage,
+					  VkAccessFlags2 dstAccess);
+
+	void imageBarrier(ImageId,
+					  VkPipelineStageFlags2 srcStage,
+					  VkAccessFlags2 srcAccess,
+					  VkPipelineStageFlags2 dstStage,
+					  VkAccessFlags2 dstAccess);
+
+	// queue family ownership transfer of an exclusive resource: the command on
+	// the source queue releases it, the one on the destination queue acquires
+	// it after waiting on the release submission; nothing is recorded when the
+	// queues belong to the same family
+	void releaseBuffer(const Buffer&,
+					   VkQueue dstQueue,
+					   VkPipelineStageFlags2 srcStage,
+					   VkAccessFlags2 srcAccess);
+
+	void acquireBuffer(const Buffer&,
+					   VkQueue srcQueue,
+					   VkPipelineStageFlags2 dstStage,
+					   VkAccessFlags2 dstAccess);
+
+	// the image stays in its current layout
+	void releaseImage(const Image&,
+					  VkQueue dstQueue,
+					  VkPipelineStageFlags2 srcStage,
+					  VkAccessFlags2 srcAccess);
+
+	void acquireImage(const Image&,
+					  VkQueue srcQueue,
+					  VkPipelineStageFlags2 dstStage,
+					  VkAccessFlags2 dstAccess);
+
 	void transitionImageLayout(ImageId, VkImageLayout);
 	void transitionToOptimalLayout(ImageId);
 
@@ -122,6 +260,8 @@ public:
 
 	void bindIndexBuffer(const Buffer&, VkDeviceSize offset = 0);
 
+	void executeSecondary(std::span<const Command* const>);
+
 	void draw(uint32_t indexCount, uint32_t firstIndex = 0);
 
 	void drawInstanced(uint32_t indexCount,
@@ -129,18 +269,98 @@ public:
 					   uint32_t firstIndex = 0,
 					   uint32_t firstInstance = 0);
 
+	void dispatch(uint32_t groupCountX,
+				  uint32_t groupCountY = 1,
+				  uint32_t groupCountZ = 1);
+
+	// the buffer holds a VkDispatchIndirectCommand at the offset
+	void dispatchIndirect(const Buffer&, VkDeviceSize offset = 0);
+
+	void dispatchIndirect(BufferId, VkDeviceSize offset = 0);
+
 	VkQueue getQueue() const { return m_queue; }
 
 	VkCommandBuffer getHandle() const { return m_commandBuffer; }
 
+	bool isSecondary() const { return m_level == VK_COMMAND_BUFFER_LEVEL_SECONDARY; }
+
+	const ElidedCalls& getElidedCalls() const { return m_elidedCalls; }
+
+	void invalidateState();
+
+private:
+	struct BindPointState {
+		VkPipeline pipeline{nullptr};
+		VkPipelineLayout layout{nullptr};
+		VkDescriptorSet descriptorSet{nullptr};
+	};
+
+	struct BoundState {
+		BindPointState graphics;
+		BindPointState compute;
+		VkBuffer indexBuffer{nullptr};
+		VkDeviceSize indexOffset{0};
+		VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+		bool hasViewport{false};
+		VkViewport viewport{};
+		bool hasScissor{false};
+		VkRect2D scissor{};
+		// a bit for each cached word, cleared when a pipeline with another
+		// layout is bound
+		VkPipelineLayout pushConstantLayout{nullptr};
+		uint32_t pushConstantMask{0};
+		std::array<uint32_t, 32> pushConstants{};
+	};
+
+private:
+	// wraps a command buffer owned by a pool
+	Command(const Device&, VkQueue, VkCommandBuffer, VkCommandBufferLevel);
+
+	StagingAllocation stageData(const void* data, VkDeviceSize size);
+
+	void releaseStaging();
+
+	// begun and not yet submitted (executed for secondary commands), resources
+	// destroyed meanwhile wait for the next submission, see Device Note 8
+	void setPending(bool) const;
+
+	void bindPipeline(VkPipelineBindPoint,
+					  BindPointState&,
+					  VkPipeline,
+					  VkPipelineLayout);
+
+	void ownershipBarrier(const Buffer&,
+						  uint32_t srcFamily,
+						  uint32_t dstFamily,
+						  VkPipelineStageFlags2 stage,
+						  VkAccessFlags2 access);
+
+	void ownershipBarrier(const Image&,
+						  uint32_t srcFamily,
+						  uint32_t dstFamily,
+						  VkPipelineStageFlags2 stage,
+						  VkAccessFlags2 access);
+
+	void pushConstantData(VkPipelineLayout,
+						  const void* data,
+						  uint32_t offset,
+						  uint32_t size);
+
 private:
 	const Device& m_device;
 	VkQueue m_queue;
 	VkCommandPool m_commandPool{nullptr};
+	VkCommandBufferLevel m_level{VK_COMMAND_BUFFER_LEVEL_PRIMARY};
 
 	VkCommandBuffer m_commandBuffer{nullptr};
+	bool m_ownsCommandBuffer{true};
 	bool m_isRecording{false};
+	mutable bool m_isPending{false};
 	bool m_pipelineBound{false};
+	bool m_computePipelineBound{false};
+	BoundState m_state;
+	ElidedCalls m_elidedCalls;
+	std::vector<StagingAllocation> m_stagingAllocations;
 	std::vector<std::unique_ptr<Buffer>> m_stagingBuffers;
 
 public:
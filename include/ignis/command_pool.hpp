@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include <memory>
+#include <vector>
+
+namespace ignis {
+
+class Device;
+class Command;
+
+struct CommandPoolCreateInfo {
+	const Device& device;
+	VkQueue queue{nullptr};  // defaults to the first graphics queue
+	uint32_t blockSize{16};	 // command buffers allocated at a time
+};
+
+// Note 1: commands are handed out until the next reset, which puts every
+// command buffer of the pool back to the initial state with a single
+// vkResetCommandPool; the submissions of the acquired commands must have
+// completed by then
+// Note 2: an acquired command can be begun once per reset
+// Note 3: the pool and its commands can be used by a single thread at a time
+// Note 4: command buffers are never freed before the pool is destroyed, the
+// pool keeps the peak number of commands acquired between two resets
+
+class CommandPool {
+public:
+	CommandPool(const CommandPoolCreateInfo&);
+
+	~CommandPool();
+
+	// the command stays valid until the next reset
+	Command& acquire(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+	void reset();
+
+	VkCommandPool getHandle() const { return m_commandPool; }
+
+	VkQueue getQueue() const { return m_queue; }
+
+private:
+	struct Commands {
+		std::vector<std::unique_ptr<Command>> commands;
+		uint32_t used{0};
+	};
+
+	void allocateBlock(Commands&, VkCommandBufferLevel);
+
+private:
+	const Device& m_device;
+	VkQueue m_queue{nullptr};
+	VkCommandPool m_commandPool{nullptr};
+	uint32_t m_blockSize{0};
+
+	Commands m_primary;
+	Commands m_secondary;
+
+public:
+	CommandPool(const CommandPool&) = delete;
+	CommandPool(CommandPool&&) = delete;
+	CommandPool& operator=(const CommandPool&) = delete;
+	CommandPool& operator=(CommandPool&&) = delete;
+};
+
+}  // namespace ignis
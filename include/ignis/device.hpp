@@ -1,18 +1,24 @@
 #pragma once
 
 #include <vulkan/vulkan_core.h>
+#include <atomic>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <array>
 #include "types.hpp"
+#include "sampler.hpp"
+#include "pipeline.hpp"
+#include "semaphore.hpp"
 
 struct VmaAllocator_T;
 
 namespace ignis {
 
-class Semaphore;
 class Fence;
 class Command;
 class Buffer;
@@ -21,10 +27,17 @@ class Image;
 struct ImageCreateInfo;
 struct DrawImageCreateInfo;
 struct DepthImageCreateInfo;
-class Sampler;
 class Shader;
 class Swapchain;
 struct SwapchainCreateInfo;
+struct ThreadCommandPoolList;
+
+struct StagingAllocation {
+	VkBuffer buffer{nullptr};
+	VkDeviceSize offset{0};
+	VkDeviceSize size{0};
+	void* mappedData{nullptr};
+};
 
 struct SubmitCmdInfo {
 	const Command& command;
@@ -32,26 +45,68 @@ struct SubmitCmdInfo {
 	std::vector<const Semaphore*> signalSemaphores;
 };
 
+inline constexpr uint32_t IGNIS_MAX_SUBMITS = 8;
+inline constexpr uint32_t IGNIS_MAX_SUBMIT_COMMANDS = 32;
+inline constexpr uint32_t IGNIS_MAX_SUBMIT_SEMAPHORES = 32;
+
+// the limits above apply to a whole submitCommands call
+struct SubmitInfo {
+	std::span<const Command* const> commands;
+	std::span<const SemaphoreSubmit> waitSemaphores{};
+	std::span<const SemaphoreSubmit> signalSemaphores{};
+};
+
 inline constexpr std::array IGNIS_REQ_FEATURES{
 	"BufferDeviceAddress",
 	"DynamicRendering",
 	"Synchronization2",
+	"TimelineSemaphore",
+	"HostQueryReset",
 	"DescriptorBindingUniformBufferUpdateAfterBind",
 	"DescriptorBindingSampledImageUpdateAfterBind",
 	"DescriptorBindingStorageBufferUpdateAfterBind",
+	"DescriptorBindingStorageImageUpdateAfterBind",
 	"DescriptorBindingPartiallyBound",
 	"RuntimeDescriptorArray",
 };
 
 // Note 1: the library supports just 1 instance, physical and logical device
-// Note 2: we handle only graphics queues
+// Note 2: we handle graphics queues, a single transfer queue, which belongs
+// to a transfer only (or async compute) family when the device has one, and
+// the queues of an async compute family (compute without graphics); when the
+// transfer queue comes from that family it takes its last queue. At most 16
+// graphics and 15 compute queues are created. Without a dedicated family the
+// compute and transfer queues alias the last graphics queue; submissions and
+// presents to a queue are serialized by its mutex, so aliased queues can be
+// used from different threads
 // Note 3: the library works only in vulkan 1.3 with dynamic rendering and other
 // required features
-// Note 4: command pools are relative to a single thread
-// Note 5: we allocate a command pool for each queue
-// Note 6: only combined image samplers are supported
+// Note 4: a command pool can be used by a single thread at a time; the pool
+// returned by getCommandPool is shared, commands recorded on worker threads
+// have to allocate from acquireCommandPool. When a thread exits its pools go
+// back to the device and the next acquiring thread resets one, so the commands
+// allocated from them must be destroyed and completed before the exit
+// Note 5: we allocate a shared command pool for each queue
+// Note 6: sampled images are bound as combined image samplers, storage images
+// in their own binding; descriptor writes are batched until the next submit
+// Note 7: uploads sub-allocate from a single device staging ring; a region is
+// reclaimed when the command that used it is re-recorded or destroyed
+// Note 8: every submission signals a timeline semaphore owned by its queue;
+// a submission on another queue is ordered after it by waiting on
+// getQueueTimeline with the returned value. Destroyed resources are released
+// once every queue has completed the values submitted before the destruction,
+// plus the next submission of queues with commands begun and not submitted
+// yet, which must carry the commands recorded before the destruction
+// Note 9: samplers are deduplicated by state and live as long as the device
+// Note 10: every pipeline is created through the device pipeline cache, which
+// is loaded from pipelineCacheFile and saved back when the device is destroyed
+// Note 11: pipelines from getOrCreatePipeline are shared between equal create
+// infos while someone holds them; shaders are compared by address, so they
+// must outlive their pipelines
 
 class Device {
+	friend class Command;
+
 public:
 	struct CreateInfo {
 		std::string appName{"Ignis App"};
@@ -59,6 +114,9 @@ public:
 		std::vector<const char*> instanceExtensions{};
 		std::vector<const char*> requiredFeatures{};
 		std::vector<const char*> optionalFeatures{};
+		VkDeviceSize stagingRingSize{32 * 1024 * 1024};  // 0 disables the ring
+		std::string traceFile{};  // chrome trace json, empty disables tracing
+		std::string pipelineCacheFile{};  // empty keeps the cache in memory
 	};
 
 	Device(const CreateInfo&);
@@ -77,12 +135,66 @@ public:
 
 	auto getQueueCount() const { return m_graphicsQueuesCount; }
 
+	auto getGraphicsFamilyIndex() const { return m_graphicsFamilyIndex; }
+
+	auto getTransferFamilyIndex() const { return m_transferFamilyIndex; }
+
+	// falls back to the last graphics queue if there is no dedicated family
+	auto getTransferQueue() const { return m_transferQueue; }
+
+	bool hasDedicatedTransferQueue() const {
+		return m_transferFamilyIndex != m_graphicsFamilyIndex;
+	}
+
+	auto getComputeFamilyIndex() const { return m_computeFamilyIndex; }
+
+	// 1 when there is no dedicated family, see Note 2
+	auto getComputeQueueCount() const {
+		return static_cast<uint32_t>(m_computeQueues.size());
+	}
+
+	bool hasDedicatedComputeQueue() const {
+		return m_computeFamilyIndex != m_graphicsFamilyIndex;
+	}
+
 public:
 	VkQueue getQueue(uint32_t index) const;
 
+	// falls back to the last graphics queue if there is no dedicated family
+	VkQueue getComputeQueue(uint32_t index = 0) const;
+
+	uint32_t getQueueFamilyIndex(VkQueue) const;
+
+	// the pool shared by every thread, see Note 4
 	VkCommandPool getCommandPool(VkQueue) const;
 
-	void submitCommands(std::vector<SubmitCmdInfo>, const Fence* fence) const;
+	// a pool owned by the calling thread for the family of the queue, one for
+	// each frame index; it is created on first use, or recycled from an exited
+	// thread, see Note 4
+	VkCommandPool acquireCommandPool(VkQueue, uint32_t frame = 0) const;
+
+	// resets the pools the calling thread acquired for the frame index, their
+	// commands must have completed
+	void resetCommandPools(uint32_t frame = 0) const;
+
+	// returns the value the queue timeline reaches when the submission completes
+	uint64_t submitCommands(std::span<const SubmitInfo>,
+							const Fence* fence = nullptr) const;
+
+	// convenience overload, it allocates on every call
+	uint64_t submitCommands(std::vector<SubmitCmdInfo>, const Fence* fence) const;
+
+	const TimelineSemaphore& getQueueTimeline(VkQueue) const;
+
+	// held by submitCommands, lock it around any other use of the queue
+	// (presents), see Note 2
+	std::mutex& getQueueMutex(VkQueue) const;
+
+	uint64_t getSubmittedValue(VkQueue) const;
+
+	uint64_t getCompletedValue(VkQueue) const;
+
+	void waitForValue(VkQueue, uint64_t value) const;
 
 	VkSampleCountFlagBits getMaxSampleCount() const;
 
@@ -92,6 +204,12 @@ public:
 
 	Buffer createStagingBuffer(VkDeviceSize, const void* data = nullptr) const;
 
+	// returns an allocation with a null buffer when the ring is full
+	StagingAllocation allocateStaging(VkDeviceSize size,
+									  VkDeviceSize alignment = 16) const;
+
+	void releaseStaging(const StagingAllocation&) const;
+
 	Buffer createIndexBuffer32(uint32_t elementCount,
 							   const uint32_t* data = nullptr) const;
 
@@ -99,19 +217,25 @@ public:
 
 	Image createDepthAttachmentImage(const DepthImageCreateInfo&) const;
 
-	Shader createShader(const std::string& shaderPath,
-						VkShaderStageFlagBits,
-						size_t pushConstansSize = 0) const;
+	// the push constant size is reflected from the code, see Shader
+	Shader createShader(const std::string& shaderPath, VkShaderStageFlagBits) const;
 
 	Shader createShader(const void* shaderCode,
 						VkDeviceSize codeSize,
-						VkShaderStageFlagBits stage,
-						size_t pushConstantSize = 0) const;
+						VkShaderStageFlagBits stage) const;
 
 	Fence createFence(bool signaled = false) const;
 
 	Semaphore createSemaphore() const;
 
+	TimelineSemaphore createTimelineSemaphore(uint64_t initialValue = 0) const;
+
+	// the device field of the info is ignored
+	VkSampler getSampler(const Sampler::SamplerInfo&) const;
+
+	// the lookup doesn't allocate when the pipeline is alive
+	std::shared_ptr<Pipeline> getOrCreatePipeline(const PipelineCreateInfo&) const;
+
 	Swapchain createSwapchain(const SwapchainCreateInfo&) const;
 
 public:
@@ -123,6 +247,9 @@ public:
 
 	ImageId createSampledImage(const ImageCreateInfo&) const;
 
+	ImageId createSampledImage(const ImageCreateInfo&,
+							   const Sampler::SamplerInfo&) const;
+
 	Buffer& getBuffer(BufferId) const;
 
 	Image& getImage(ImageId) const;
@@ -131,6 +258,11 @@ public:
 
 	void destroyImage(ImageId);
 
+	// releases destroyed resources whose last use has been retired by the GPU
+	void collectGarbage();
+
+	// writes the mapping right away, the buffer must be host visible and not
+	// in use by the GPU; Command::updateBuffer records the write instead
 	void updateBuffer(BufferId,
 					  const void* data,
 					  VkDeviceSize offset = 0,
@@ -140,6 +272,12 @@ public:
 
 	VkDescriptorSet getDescriptorSet() const;
 
+	VkPipelineCache getPipelineCache() const;
+
+	// writes the pipeline cache file, e.g. after warming up the pipelines;
+	// returns false if it couldn't be written
+	bool savePipelineCache() const;
+
 private:
 	VkInstance m_instance{nullptr};
 	VkDebugUtilsMessengerEXT m_debugMessenger{nullptr};
@@ -154,10 +292,58 @@ private:
 	class GpuResources;
 	std::unique_ptr<GpuResources> m_gpuResources;
 
+	class StagingRing;
+	std::unique_ptr<StagingRing> m_stagingRing;
+
+	class PipelineCache;
+	std::unique_ptr<PipelineCache> m_pipelineCache;
+
 	uint32_t m_graphicsFamilyIndex{0};
 	uint32_t m_graphicsQueuesCount{0};
 	std::vector<VkQueue> m_queues;
+	uint32_t m_transferFamilyIndex{0};
+	VkQueue m_transferQueue{nullptr};
+	uint32_t m_computeFamilyIndex{0};
+	std::vector<VkQueue> m_computeQueues;
 	std::unordered_map<VkQueue, VkCommandPool> m_commandPools;
+	std::shared_ptr<ThreadCommandPoolList> m_threadCommandPools;
+	const uint64_t m_id;
+
+	mutable std::unordered_map<Sampler::SamplerInfo,
+							   std::unique_ptr<Sampler>,
+							   Sampler::Hash>
+		m_samplers;
+	mutable std::mutex m_samplersMutex;
+
+	mutable std::unordered_map<PipelineCreateInfo,
+							   std::weak_ptr<Pipeline>,
+							   PipelineCreateInfo::Hash>
+		m_pipelines;
+	mutable std::mutex m_pipelinesMutex;
+	mutable size_t m_pipelinesPruneSize{64};
+
+	struct QueueTimeline {
+		VkQueue queue{nullptr};
+		std::unique_ptr<TimelineSemaphore> semaphore;
+		mutable std::atomic<uint64_t> submittedValue{0};
+		// begun and not submitted yet, see Note 8
+		mutable std::atomic<uint32_t> pendingCommands{0};
+		// held while submitting or presenting, see Note 2
+		mutable std::mutex submitMutex;
+	};
+
+	std::deque<QueueTimeline> m_queueTimelines;
+
+	const QueueTimeline& getTimeline(VkQueue) const;
+	std::vector<uint64_t> getRetireValues() const;
+
+	// one value per queue timeline, filled without allocating in the submit path
+	static constexpr uint32_t MAX_QUEUES = 32;
+	using QueueValues = std::array<uint64_t, MAX_QUEUES>;
+
+	std::span<const uint64_t> getCompletedValues(QueueValues&) const;
+
+	void setCommandPending(VkQueue, bool pending) const;
 
 public:
 	Device(const Device&) = delete;
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ignis {
+
+class Device;
+class Command;
+class CommandPool;
+class Semaphore;
+class Swapchain;
+struct Image;
+
+struct FrameSchedulerCreateInfo {
+	Device& device;
+	Swapchain* swapchain{nullptr};  // null for headless rendering
+	VkQueue queue{nullptr};			// defaults to the first graphics queue
+	uint32_t framesInFlight{2};
+};
+
+// Note 1: each frame in flight owns a command pool, the staging regions of
+// its commands (released when the pool is reset) and a deletion queue; a frame
+// slot is reused only once the queue timeline has passed its last submission
+// Note 2: beginFrame waits for the frame submitted framesInFlight frames ago,
+// never for the previous one, so the cpu records while the gpu renders
+// Note 3: the swapchain image has to be transitioned to PRESENT_SRC before
+// endFrame, the scheduler doesn't track its layout
+// Note 4: the queue is also the presentation queue
+// Note 5: the scheduler is not thread safe
+
+class FrameScheduler {
+public:
+	FrameScheduler(const FrameSchedulerCreateInfo&);
+
+	~FrameScheduler();
+
+	// waits for the frame slot, runs its deletion queue, resets its command
+	// pool, acquires the next swapchain image and begins the frame command
+	Command& beginFrame();
+
+	// submits the frame command and presents the swapchain image
+	void endFrame();
+
+	// runs the callback once the gpu has finished with the current frame (or
+	// with the last submitted one, when called between frames)
+	void deferDeletion(std::function<void()>);
+
+	// null when the scheduler has no swapchain
+	Image* getSwapchainImage() const { return m_swapchainImage; }
+
+	Command& getCommand() const;
+
+	// for additional commands of the current frame, e.g. secondary ones; they
+	// are valid until the frame slot is reused
+	CommandPool& getCommandPool() const;
+
+	uint32_t getFrameIndex() const { return m_currentFrame; }
+
+	uint64_t getFrameNumber() const { return m_frameNumber; }
+
+	uint32_t getFramesInFlight() const { return m_frames.size(); }
+
+	// waits for every submitted frame and runs all the deletion queues
+	void waitIdle();
+
+private:
+	struct Frame {
+		std::unique_ptr<CommandPool> commandPool;
+		Command* command{nullptr};
+		std::unique_ptr<Semaphore> imageAvailable;
+		uint64_t value{0};
+		std::vector<std::function<void()>> deletionQueue;
+	};
+
+	void flushDeletionQueue(Frame&);
+
+private:
+	Device& m_device;
+	Swapchain* m_swapchain{nullptr};
+	VkQueue m_queue{nullptr};
+
+	std::vector<Frame> m_frames;
+	// indexed by swapchain image, the presentation may outlive the frame slot
+	std::vector<std::unique_ptr<Semaphore>> m_renderFinished;
+
+	uint32_t m_currentFrame{0};
+	uint64_t m_frameNumber{0};
+	Image* m_swapchainImage{nullptr};
+	uint32_t m_swapchainImageIndex{0};
+	bool m_inFrame{false};
+
+public:
+	FrameScheduler(const FrameScheduler&) = delete;
+	FrameScheduler(FrameScheduler&&) = delete;
+	FrameScheduler& operator=(const FrameScheduler&) = delete;
+	FrameScheduler& operator=(FrameScheduler&&) = delete;
+};
+
+}  // namespace ignis
@@ -45,6 +45,7 @@ struct DrawImageCreateInfo {
 
 struct Image {
 	friend class Command;
+	friend class UploadQueue;
 
 public:
 	// wrapper
@@ -33,9 +33,18 @@ struct PipelineCreateInfo {
 	VkBlendFactor srcAlphaBlendFactor{VK_BLEND_FACTOR_ONE};
 	VkBlendFactor dstAlphaBlendFactor{VK_BLEND_FACTOR_ZERO};
 	VkBlendOp alphaBlendOp{VK_BLEND_OP_ADD};
+
+	// shaders are compared by identity, not by code
+	bool operator==(const PipelineCreateInfo&) const = default;
+
+	// hashes the whole state, the device is ignored
+	struct Hash {
+		size_t operator()(const PipelineCreateInfo&) const;
+	};
 };
 
-// Note 1: for now we handle only graphics pipelines
+// Note 1: compute pipelines are ComputePipeline objects, they share the
+// bindless set and the push constant layouts with the graphics ones
 // Note 2: we can't render to multiple images, just to a single one
 // Note 3: dynamic rendering only
 
@@ -61,4 +70,31 @@ public:
 	Pipeline& operator=(Pipeline&&) = delete;
 };
 
+struct ComputePipelineCreateInfo {
+	const Device* device{nullptr};
+	Shader* shader{nullptr};
+};
+
+class ComputePipeline {
+public:
+	ComputePipeline(const ComputePipelineCreateInfo&);
+
+	~ComputePipeline();
+
+	VkPipeline getHandle() const { return m_pipeline; }
+
+	VkPipelineLayout getLayoutHandle() const { return m_pipelineLayout; }
+
+private:
+	const Device& m_device;
+	VkPipelineLayout m_pipelineLayout{VK_NULL_HANDLE};
+	VkPipeline m_pipeline{VK_NULL_HANDLE};
+
+public:
+	ComputePipeline(const ComputePipeline&) = delete;
+	ComputePipeline(ComputePipeline&&) = delete;
+	ComputePipeline& operator=(const ComputePipeline&) = delete;
+	ComputePipeline& operator=(ComputePipeline&&) = delete;
+};
+
 }  // namespace ignis
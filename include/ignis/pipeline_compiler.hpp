@@ -0,0 +1,97 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+#include "pipeline.hpp"
+
+namespace ignis {
+
+class Device;
+
+struct PipelineCompilerCreateInfo {
+	const Device& device;
+	uint32_t threadCount{0};  // 0 uses all the cores but one
+};
+
+// a pipeline compiled in the background, copies share the same pipeline
+class AsyncPipeline {
+public:
+	AsyncPipeline() = default;
+
+	AsyncPipeline(std::shared_future<std::shared_ptr<Pipeline>> future)
+		: m_future(std::move(future)) {}
+
+	bool isValid() const { return m_future.valid(); }
+
+	bool isReady() const;
+
+	// the compiled pipeline, or the fallback until it is ready (or if its
+	// compilation failed)
+	const Pipeline& getOr(const Pipeline& fallback) const;
+
+	// blocks until the pipeline is ready, rethrows the compilation error
+	std::shared_ptr<Pipeline> wait() const { return m_future.get(); }
+
+private:
+	std::shared_future<std::shared_ptr<Pipeline>> m_future;
+};
+
+// Note 1: the shaders of a create info must outlive its compilation
+// Note 2: pipelines still queued when the compiler is destroyed are dropped,
+// waiting for them throws a broken promise error
+// Note 3: pipelines are created through the device pipeline cache, which is
+// internally synchronized
+// Note 4: create infos without a device are compiled on the compiler device,
+// the ones with a device must use the same
+
+class PipelineCompiler {
+public:
+	PipelineCompiler(const PipelineCompilerCreateInfo&);
+
+	~PipelineCompiler();
+
+	AsyncPipeline compile(const PipelineCreateInfo&);
+
+	// queued in order, the result is parallel to the create infos
+	std::vector<AsyncPipeline> compile(std::span<const PipelineCreateInfo>);
+
+	// blocks until every queued pipeline has been compiled
+	void waitIdle();
+
+	uint32_t getThreadCount() const { return m_workers.size(); }
+
+private:
+	struct Job {
+		PipelineCreateInfo info;
+		std::promise<std::shared_ptr<Pipeline>> promise;
+	};
+
+	AsyncPipeline enqueue(const PipelineCreateInfo&);
+
+	void work();
+
+private:
+	const Device& m_device;
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_mutex;
+	std::condition_variable m_jobAvailable;
+	std::condition_variable m_idle;
+	std::deque<Job> m_jobs;
+	uint32_t m_activeJobs{0};
+	bool m_stop{false};
+
+public:
+	PipelineCompiler(const PipelineCompiler&) = delete;
+	PipelineCompiler(PipelineCompiler&&) = delete;
+	PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+	PipelineCompiler& operator=(PipelineCompiler&&) = delete;
+};
+
+}  // namespace ignis
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ignis {
+
+class Device;
+class Command;
+
+struct GpuProfilerCreateInfo {
+	const Device& device;
+	uint32_t framesInFlight{2};
+	uint32_t maxZonesPerFrame{64};
+	uint32_t historySize{120};
+};
+
+struct GpuZoneResult {
+	const char* name{nullptr};
+	uint32_t depth{0};
+	uint64_t frame{0};
+	double beginMs{0.0};  // relative to the first zone of the frame
+	double endMs{0.0};
+	uint64_t beginTicks{0};
+	uint64_t endTicks{0};
+};
+
+// Note 1: queries are reset from the host, HostQueryReset is a required feature
+// Note 2: results are resolved in beginFrame without waiting, so they come
+// framesInFlight frames late at most; zones whose queries are not available
+// when their pool is reused are dropped
+// Note 3: zone names are not copied, they have to outlive the resolution
+// Note 4: timestamps are only valid on the graphics queue family, zones must
+// be recorded in commands for a graphics queue
+// Note 5: the profiler is not thread safe
+// Note 6: when the device traces, resolved zones are added as gpu spans; the
+// gpu clock is aligned to the cpu once, when the profiler is created
+
+class GpuProfiler {
+public:
+	GpuProfiler(const GpuProfilerCreateInfo&);
+
+	~GpuProfiler();
+
+	// resolves the finished frames and starts recording zones in the next pool;
+	// call it after waiting for the frame that used the pool before
+	void beginFrame();
+
+	// returns UINT32_MAX if the frame ran out of queries
+	uint32_t beginZone(Command&, const char* name);
+
+	void endZone(Command&, uint32_t zone);
+
+	// zones of the last resolved frame, ordered by their begin
+	const std::vector<GpuZoneResult>& getLastResults() const {
+		return m_lastResults;
+	}
+
+	const std::deque<double>& getZoneHistory(const std::string& name) const;
+
+	double getAverageMs(const std::string& name) const;
+
+	double getTimestampPeriod() const { return m_timestampPeriod; }
+
+private:
+	struct Zone {
+		const char* name{nullptr};
+		uint32_t depth{0};
+		uint32_t beginQuery{0};
+		uint32_t endQuery{0};
+	};
+
+	struct Frame {
+		VkQueryPool queryPool{nullptr};
+		uint32_t queryCount{0};
+		uint64_t number{0};
+		bool pending{false};
+		std::vector<Zone> zones;
+	};
+
+	// returns false if some queries are not available yet, unless partial
+	bool resolveFrame(Frame&, bool partial);
+
+	// blocks until a timestamp written on the graphics queue is available
+	void calibrate(const Device&);
+
+	uint64_t toTraceTime(uint64_t ticks) const;
+
+private:
+	const Device& m_parentDevice;
+	VkDevice m_device{nullptr};
+	uint32_t m_maxQueries{0};
+	uint32_t m_historySize{0};
+	double m_timestampPeriod{1.0};
+	uint64_t m_timestampMask{UINT64_MAX};
+	uint64_t m_calibrationTicks{0};
+	uint64_t m_calibrationNs{0};
+
+	std::vector<Frame> m_frames;
+	uint32_t m_currentFrame{0};
+	uint64_t m_frameNumber{0};
+	uint32_t m_depth{0};
+
+	std::vector<uint64_t> m_queryResults;
+	std::vector<GpuZoneResult> m_lastResults;
+	std::unordered_map<std::string, std::deque<double>> m_history;
+
+public:
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler(GpuProfiler&&) = delete;
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+	GpuProfiler& operator=(GpuProfiler&&) = delete;
+};
+
+}  // namespace ignis
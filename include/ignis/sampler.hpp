@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vulkan/vulkan_core.h>
+#include <cstddef>
 
 namespace ignis {
 
@@ -25,6 +26,13 @@ public:
 		float m_maxLod{0.0f};
 		VkBorderColor m_borderColor{VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK};
 		VkBool32 m_unnormalizedCoordinates{VK_FALSE};
+
+		bool operator==(const SamplerInfo&) const = default;
+	};
+
+	// hashes the sampler state, the device is ignored
+	struct Hash {
+		size_t operator()(const SamplerInfo&) const;
 	};
 
 	Sampler(SamplerInfo info);
@@ -32,9 +40,17 @@ public:
 
 	VkSampler getHandle() const { return m_sampler; }
 
+	const SamplerInfo& getInfo() const { return m_info; }
+
 private:
 	VkSampler m_sampler{VK_NULL_HANDLE};
 	SamplerInfo m_info;
+
+public:
+	Sampler(const Sampler&) = delete;
+	Sampler(Sampler&&) = delete;
+	Sampler& operator=(const Sampler&) = delete;
+	Sampler& operator=(Sampler&&) = delete;
 };
 
 }  // namespace ignis
@@ -1,9 +1,17 @@
 #pragma once
 
 #include <vulkan/vulkan_core.h>
+#include <cstdint>
+#include <span>
 
 namespace ignis {
 
+struct SemaphoreSubmit {
+	VkSemaphore semaphore{nullptr};
+	uint64_t value{0};  // ignored by binary semaphores
+	VkPipelineStageFlags2 stageMask{VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT};
+};
+
 class Semaphore {
 public:
 	Semaphore(const VkDevice);
@@ -11,6 +19,11 @@ public:
 
 	auto getHandle() const { return m_semaphore; }
 
+	SemaphoreSubmit getSubmitInfo(VkPipelineStageFlags2 stageMask =
+									  VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT) const {
+		return {.semaphore = m_semaphore, .stageMask = stageMask};
+	}
+
 private:
 	const VkDevice m_device;
 	VkSemaphore m_semaphore{nullptr};
@@ -22,4 +35,46 @@ public:
 	Semaphore& operator=(Semaphore&&) = delete;
 };
 
+// Note 1: a timeline semaphore is a monotonic counter, a submission waits for
+// or signals a value through the SemaphoreSubmit returned by getSubmitInfo
+// Note 2: waits return false on timeout instead of throwing
+
+class TimelineSemaphore {
+public:
+	TimelineSemaphore(const VkDevice, uint64_t initialValue = 0);
+	~TimelineSemaphore();
+
+	auto getHandle() const { return m_semaphore; }
+
+	SemaphoreSubmit getSubmitInfo(uint64_t value,
+								  VkPipelineStageFlags2 stageMask =
+									  VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT) const {
+		return {.semaphore = m_semaphore, .value = value, .stageMask = stageMask};
+	}
+
+	uint64_t getValue() const;
+
+	bool wait(uint64_t value, uint64_t timeout = UINT64_MAX) const;
+
+	// signals from the host
+	void signal(uint64_t value) const;
+
+	// every semaphore has to reach its value (or any of them, if waitAll is
+	// false); all the semaphores must belong to the same device
+	static bool wait(std::span<const TimelineSemaphore* const>,
+					 std::span<const uint64_t> values,
+					 bool waitAll = true,
+					 uint64_t timeout = UINT64_MAX);
+
+private:
+	const VkDevice m_device;
+	VkSemaphore m_semaphore{nullptr};
+
+public:
+	TimelineSemaphore(const TimelineSemaphore&) = delete;
+	TimelineSemaphore(TimelineSemaphore&&) = delete;
+	TimelineSemaphore& operator=(const TimelineSemaphore&) = delete;
+	TimelineSemaphore& operator=(TimelineSemaphore&&) = delete;
+};
+
 }  // namespace ignis
@@ -1,23 +1,32 @@
 #pragma once
 
 #include <vulkan/vulkan_core.h>
+#include <array>
 #include <string>
 #include <vector>
 
 namespace ignis {
 
+struct SpecializationConstant {
+	uint32_t id;
+	uint32_t size;	// in bytes, booleans are VkBool32
+	uint64_t defaultValue{0};
+};
+
+// Note 1: the push constant size, entry point, specialization constants and
+// workgroup size are reflected from the SPIR-V code when the shader is loaded
+// Note 2: the entry point is the first one of the module for the stage
+
 class Shader {
 public:
 	Shader(const VkDevice,
 		   const void*,
 		   VkDeviceSize codeSize,
-		   VkShaderStageFlagBits,
-		   VkDeviceSize pushConstantsSize = 0);
+		   VkShaderStageFlagBits);
 
 	static Shader fromFile(VkDevice device,
 						   const std::string& path,
-						   VkShaderStageFlagBits stage,
-						   VkDeviceSize pushConstantSize = 0);
+						   VkShaderStageFlagBits stage);
 
 	~Shader();
 
@@ -25,15 +34,29 @@ public:
 
 	auto getStage() const { return m_stage; }
 
+	// the end of the push constant block, rounded up to a word
 	auto getPushConstantSize() const { return m_pushConstantSize; }
 
+	const std::string& getEntryPoint() const { return m_entryPoint; }
+
+	// sorted by id
+	const auto& getSpecializationConstants() const {
+		return m_specializationConstants;
+	}
+
+	// 1, 1, 1 for stages other than compute, mesh and task
+	auto getWorkgroupSize() const { return m_workgroupSize; }
+
 	static uint32_t getMergedPushConstantSize(const std::vector<Shader*>&);
 
 private:
 	const VkDevice m_device;
 	VkShaderModule m_module{nullptr};
-	uint32_t m_pushConstantSize;
+	uint32_t m_pushConstantSize{0};
 	VkShaderStageFlagBits m_stage;
+	std::string m_entryPoint;
+	std::vector<SpecializationConstant> m_specializationConstants;
+	std::array<uint32_t, 3> m_workgroupSize{1, 1, 1};
 
 public:
 	Shader(const Shader&) = delete;
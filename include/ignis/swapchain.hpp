@@ -34,10 +34,13 @@ public:
 
 	Image& getCurrentImage() { return *m_images[m_currentImageIndex]; }
 
+	uint32_t getCurrentImageIndex() const { return m_currentImageIndex; }
+
 	Image& acquireNextImage(const Semaphore* signalSemaphore);
 
 	uint32_t getImagesCount() const { return m_images.size(); }
 
+	// the caller holds Device::getQueueMutex of the presentation queue
 	void presentCurrent(const PresentInfo&) const;
 
 private:
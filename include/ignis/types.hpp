@@ -7,11 +7,26 @@ namespace ignis {
 #define IGNIS_STORAGE_BUFFER_BINDING 0
 #define IGNIS_UNIFORM_BUFFER_BINDING 1
 #define IGNIS_IMAGE_SAMPLER_BINDING 2
+#define IGNIS_STORAGE_IMAGE_BINDING 3
 
 #define IGNIS_INVALID_BUFFER_ID UINT32_MAX
 #define IGNIS_INVALID_IMAGE_ID UINT32_MAX
 
+// the low bits of a resource id are its index in the bindless descriptor
+// arrays (what shaders index with), the high bits are a generation counter
+// used to detect stale handles after the index has been recycled
+#define IGNIS_RESOURCE_INDEX_BITS 20
+#define IGNIS_RESOURCE_INDEX_MASK ((1u << IGNIS_RESOURCE_INDEX_BITS) - 1)
+
+// uniform buffers get their own index space, the top bit of their ids tells
+// them apart from storage buffer ids with the same index
+#define IGNIS_RESOURCE_TAG_BIT (1u << 31)
+
 typedef uint32_t BufferId;
 typedef uint32_t ImageId;
 
+inline constexpr uint32_t getResourceIndex(uint32_t id) {
+	return id & IGNIS_RESOURCE_INDEX_MASK;
+}
+
 }  // namespace ignis
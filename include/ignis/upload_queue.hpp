@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include <memory>
+#include <vector>
+#include "types.hpp"
+
+namespace ignis {
+
+class Device;
+class Command;
+class CommandPool;
+class Buffer;
+class Semaphore;
+class TimelineSemaphore;
+struct Image;
+
+struct UploadQueueCreateInfo {
+	const Device& device;
+	uint32_t batchesInFlight{3};
+};
+
+// Note 1: uploads are recorded on the device transfer queue and submitted in
+// batches; completion is tracked with the transfer queue timeline
+// Note 2: resources are released to the graphics family at the end of a batch,
+// the matching acquire barriers are recorded with acquireOwnership
+// Note 3: uploads overwrite the destination, images are expected to be in
+// UNDEFINED layout or already owned by the transfer queue
+// Note 4: the transfer queue falls back to a graphics queue on devices without
+// a dedicated family; the device serializes the submissions to it, but its
+// release barriers become plain transitions since both families are the same
+
+class UploadQueue {
+public:
+	UploadQueue(const UploadQueueCreateInfo&);
+
+	~UploadQueue();
+
+	void uploadBuffer(const Buffer&,
+					  const void* data,
+					  VkDeviceSize offset = 0,
+					  VkDeviceSize size = 0);
+
+	void uploadBuffer(BufferId,
+					  const void* data,
+					  VkDeviceSize offset = 0,
+					  VkDeviceSize size = 0);
+
+	void uploadImage(Image&,
+					 const void* pixels,
+					 VkOffset2D imageOffset = {0, 0},
+					 VkExtent2D imageSize = {0, 0});
+
+	void uploadImage(ImageId,
+					 const void* pixels,
+					 VkOffset2D imageOffset = {0, 0},
+					 VkExtent2D imageSize = {0, 0});
+
+	// submits the pending uploads and returns the timeline value signaled when
+	// they complete; the optional binary semaphore lets a graphics submission
+	// wait for them on the GPU
+	uint64_t flush(const Semaphore* signalSemaphore = nullptr);
+
+	// records the acquire side of the ownership transfers of every flushed
+	// batch; the command has to be submitted after waiting for the flush
+	void acquireOwnership(Command&);
+
+	bool isComplete(uint64_t value) const;
+
+	void wait(uint64_t value) const;
+
+	uint64_t getCompletedValue() const;
+
+	const TimelineSemaphore& getTimelineSemaphore() const;
+
+private:
+	struct Batch {
+		std::unique_ptr<CommandPool> commandPool;
+		Command* command{nullptr};
+		uint64_t value{0};
+	};
+
+	Command& getRecordingCommand();
+
+	void releaseBuffer(const Buffer&, VkDeviceSize offset, VkDeviceSize size);
+
+	void releaseImage(const Image&, VkImageLayout finalLayout);
+
+private:
+	const Device& m_device;
+	VkQueue m_queue{nullptr};
+	uint32_t m_srcFamilyIndex{0};
+	uint32_t m_dstFamilyIndex{0};
+	uint64_t m_lastSubmittedValue{0};
+
+	std::vector<Batch> m_batches;
+	uint32_t m_currentBatch{0};
+	bool m_isRecording{false};
+
+	std::vector<VkBufferMemoryBarrier2> m_releaseBufferBarriers;
+	std::vector<VkImageMemoryBarrier2> m_releaseImageBarriers;
+	std::vector<VkBufferMemoryBarrier2> m_acquireBufferBarriers;
+	std::vector<VkImageMemoryBarrier2> m_acquireImageBarriers;
+
+public:
+	UploadQueue(const UploadQueue&) = delete;
+	UploadQueue(UploadQueue&&) = delete;
+	UploadQueue& operator=(const UploadQueue&) = delete;
+	UploadQueue& operator=(UploadQueue&&) = delete;
+};
+
+}  // namespace ignis
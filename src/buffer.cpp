@@ -21,14 +21,34 @@ Buffer::Buffer(VmaAllocator allocator, const BufferCreateInfo& info)
 		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
 	};
 
-	VmaAllocationCreateInfo const allocationInfo{
+	VmaAllocationCreateInfo allocationInfo{
 		.requiredFlags = info.memoryProperties,
 	};
 
+	// host visible buffers stay mapped for their whole lifetime
+	if (info.memoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		allocationInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+	} else if (info.allowHostAccess) {
+		// picks DEVICE_LOCAL | HOST_VISIBLE memory when there is some, otherwise
+		// plain device local memory is used and the buffer is not mapped
+		allocationInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+		allocationInfo.flags =
+			VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+			VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT |
+			VMA_ALLOCATION_CREATE_MAPPED_BIT;
+	}
+
+	VmaAllocationInfo allocationResult{};
+
 	THROW_VULKAN_ERROR(vmaCreateBuffer(m_allocator, &bufferInfo, &allocationInfo,
-									   &m_buffer, &m_allocation, nullptr),
+									   &m_buffer, &m_allocation, &allocationResult),
 					   "Failed to allocate buffer");
 
+	m_mappedData = allocationResult.pMappedData;
+
+	// the chosen memory type may have more properties than the required ones
+	vmaGetAllocationMemoryProperties(m_allocator, m_allocation, &m_memoryProperties);
+
 	if (info.initialData) {
 		writeData(info.initialData);
 	}
@@ -44,14 +64,17 @@ Buffer::Buffer(Buffer&& other) noexcept
 	  m_bufferUsage(other.m_bufferUsage),
 	  m_size(other.m_size),
 	  m_buffer(other.m_buffer),
-	  m_allocation(other.m_allocation) {
+	  m_allocation(other.m_allocation),
+	  m_mappedData(other.m_mappedData) {
 	other.m_buffer = VK_NULL_HANDLE;
 	other.m_allocation = VK_NULL_HANDLE;
+	other.m_mappedData = nullptr;
 }
 
-void Buffer::writeData(const void* data, VkDeviceSize offset, uint32_t size) {
-	THROW_ERROR(!(m_memoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT),
-				"Writing to non-host visible buffer");
+void Buffer::writeData(const void* data,
+					   VkDeviceSize offset,
+					   uint32_t size) const {
+	THROW_ERROR(m_mappedData == nullptr, "Writing to non-host visible buffer");
 
 	if (!size) {
 		size = m_size - offset;
@@ -59,41 +82,43 @@ void Buffer::writeData(const void* data, VkDeviceSize offset, uint32_t size) {
 
 	THROW_ERROR(offset + size > m_size, "Out of bounds");
 
-	void* mappedData = nullptr;
-
-	vmaMapMemory(m_allocator, m_allocation, &mappedData);
-
-	char* dst = static_cast<char*>(mappedData) + offset;
+	char* dst = static_cast<char*>(m_mappedData) + offset;
 	memcpy(dst, data, size);
 
-	if (!(m_memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
-		vmaFlushAllocation(m_allocator, m_allocation, offset, size);
-	}
-
-	vmaUnmapMemory(m_allocator, m_allocation);
+	flush(offset, size);
 }
 
-void Buffer::readData(void* data, VkDeviceSize offset, uint32_t size) {
-	THROW_ERROR(!(m_memoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT),
-				"Reading from non-host visible buffer");
+void Buffer::readData(void* data, VkDeviceSize offset, uint32_t size) const {
+	THROW_ERROR(m_mappedData == nullptr, "Reading from non-host visible buffer");
 
 	if (!size) {
 		size = m_size - offset;
 	}
 
-	THROW_ERROR(offset + size > size, "Out of bounds");
+	THROW_ERROR(offset + size > m_size, "Out of bounds");
 
-	void* mappedData = nullptr;
-	vmaMapMemory(m_allocator, m_allocation, &mappedData);
+	invalidate(offset, size);
 
-	char* src = static_cast<char*>(mappedData) + offset;
+	const char* src = static_cast<const char*>(m_mappedData) + offset;
 	memcpy(data, src, size);
+}
+
+void Buffer::flush(VkDeviceSize offset, VkDeviceSize size) const {
+	if (m_memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+		return;
+	}
 
-	vmaUnmapMemory(m_allocator, m_allocation);
+	vmaFlushAllocation(m_allocator, m_allocation, offset,
+					   size ? size : VK_WHOLE_SIZE);
+}
 
-	if (!(m_memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
-		vmaInvalidateAllocation(m_allocator, m_allocation, offset, size);
+void Buffer::invalidate(VkDeviceSize offset, VkDeviceSize size) const {
+	if (m_memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+		return;
 	}
+
+	vmaInvalidateAllocation(m_allocator, m_allocation, offset,
+							size ? size : VK_WHOLE_SIZE);
 }
 
 VkDeviceAddress Buffer::getDeviceAddress(VkDevice device) const {
@@ -129,11 +154,14 @@ Buffer Buffer::allocateSSBO(VmaAllocator allocator,
 	VkDeviceSize bufferSize = (size + alignment - 1) & ~(alignment - 1);
 
 	BufferCreateInfo info{
-		.bufferUsage =
-			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		// compute shaders can write indirect arguments into storage buffers
+		.bufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+					   VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+					   VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
 		.memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		.size = bufferSize,
 		.initialData = data,
+		.allowHostAccess = true,
 	};
 
 	return Buffer(allocator, std::move(info));
@@ -148,6 +176,7 @@ Buffer Buffer::allocateIndexBuffer32(VmaAllocator allocator,
 		.memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		.size = sizeof(uint32_t) * elementCount,
 		.initialData = data,
+		.allowHostAccess = true,
 	};
 
 	return Buffer(allocator, std::move(info));
@@ -1,9 +1,13 @@
+#include <array>
+#include <cstring>
 #include "ignis/command.hpp"
 #include "ignis/buffer.hpp"
 #include "ignis/device.hpp"
 #include "ignis/image.hpp"
 #include "ignis/sampler.hpp"
+#include "ignis/profiler.hpp"
 #include "exceptions.hpp"
+#include "trace.hpp"
 #include "vk_utils.hpp"
 
 using namespace ignis;
@@ -11,11 +15,13 @@ using namespace ignis;
 Command::Command(const CommandCreateInfo& info)
 	: m_device(info.device),
 	  m_queue(info.queue != nullptr ? info.queue : m_device.getQueue(0)),
-	  m_commandPool(m_device.getCommandPool(m_queue)) {
+	  m_commandPool(info.commandPool != nullptr ? info.commandPool
+												: m_device.getCommandPool(m_queue)),
+	  m_level(info.level) {
 	VkCommandBufferAllocateInfo const allocInfo{
 		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
 		.commandPool = m_commandPool,
-		.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		.level = m_level,
 		.commandBufferCount = 1,
 	};
 
@@ -24,15 +30,35 @@ Command::Command(const CommandCreateInfo& info)
 		"Failed to allocate command buffer");
 }
 
+Command::Command(const Device& device,
+				 VkQueue queue,
+				 VkCommandBuffer commandBuffer,
+				 VkCommandBufferLevel level)
+	: m_device(device),
+	  m_queue(queue),
+	  m_level(level),
+	  m_commandBuffer(commandBuffer),
+	  m_ownsCommandBuffer(false) {}
+
 Command::~Command() {
-	m_stagingBuffers.clear();
-	vkFreeCommandBuffers(m_device.getDevice(), m_commandPool, 1, &m_commandBuffer);
+	setPending(false);
+
+	releaseStaging();
+
+	if (m_ownsCommandBuffer) {
+		vkFreeCommandBuffers(m_device.getDevice(), m_commandPool, 1,
+							 &m_commandBuffer);
+	}
 }
 
 void Command::begin(VkCommandBufferUsageFlags flags) {
+	IGNIS_TRACE_SCOPE("Command::begin");
+
 	assert(!m_isRecording);
+	assert(!isSecondary() && "Secondary commands are begun with beginSecondary");
 
-	m_stagingBuffers.clear();
+	// the previous submission of this command has completed
+	releaseStaging();
 
 	VkCommandBufferBeginInfo const beginInfo{
 		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -42,11 +68,94 @@ void Command::begin(VkCommandBufferUsageFlags flags) {
 	THROW_VULKAN_ERROR(vkBeginCommandBuffer(m_commandBuffer, &beginInfo),
 					   "Failed to begin recording command");
 
+	setPending(true);
+
 	m_isRecording = true;
 	m_pipelineBound = false;
+	m_computePipelineBound = false;
+	m_state = {};
+	m_elidedCalls = {};
+}
+
+void Command::beginSecondary(const DrawAttachment* drawAttachment,
+							 const DepthAttachment* depthAttachment,
+							 VkCommandBufferUsageFlags flags) {
+	IGNIS_TRACE_SCOPE("Command::beginSecondary");
+
+	assert(!m_isRecording);
+	assert(isSecondary() && "Command is not secondary");
+	assert(drawAttachment != nullptr ||
+		   depthAttachment != nullptr && "Both attachments are nullptr");
+
+	releaseStaging();
+
+	VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+	VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+	if (drawAttachment != nullptr) {
+		assert(drawAttachment->drawImage != nullptr && "Draw image is invalid");
+
+		colorFormat = drawAttachment->drawImage->getFormat();
+		samples = drawAttachment->drawImage->getSampleCount();
+	}
+
+	if (depthAttachment != nullptr) {
+		assert(depthAttachment->depthImage != nullptr && "Depth image is invalid");
+
+		depthFormat = depthAttachment->depthImage->getFormat();
+		samples = depthAttachment->depthImage->getSampleCount();
+	}
+
+	VkCommandBufferInheritanceRenderingInfo const renderingInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+		.colorAttachmentCount = drawAttachment != nullptr ? 1u : 0,
+		.pColorAttachmentFormats = &colorFormat,
+		.depthAttachmentFormat = depthFormat,
+		.rasterizationSamples = samples,
+	};
+
+	VkCommandBufferInheritanceInfo const inheritanceInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+		.pNext = &renderingInfo,
+	};
+
+	VkCommandBufferBeginInfo const beginInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = flags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+		.pInheritanceInfo = &inheritanceInfo,
+	};
+
+	THROW_VULKAN_ERROR(vkBeginCommandBuffer(m_commandBuffer, &beginInfo),
+					   "Failed to begin recording command");
+
+	setPending(true);
+
+	m_isRecording = true;
+	m_pipelineBound = false;
+	m_computePipelineBound = false;
+	m_state = {};
+	m_elidedCalls = {};
+}
+
+Command::ProfileZone::ProfileZone(Command& command,
+								  GpuProfiler& profiler,
+								  const char* name)
+	: m_command(command), m_profiler(profiler) {
+	assert(m_command.m_isRecording && "Command buffer is not recording!");
+
+	m_zone = m_profiler.beginZone(m_command, name);
+}
+
+Command::ProfileZone::~ProfileZone() {
+	assert(m_command.m_isRecording && "Command buffer is not recording!");
+
+	m_profiler.endZone(m_command, m_zone);
 }
 
 void Command::end() {
+	IGNIS_TRACE_SCOPE("Command::end");
+
 	CHECK_IS_RECORDING;
 
 	THROW_VULKAN_ERROR(vkEndCommandBuffer(m_commandBuffer),
@@ -55,6 +164,49 @@ void Command::end() {
 	m_isRecording = false;
 }
 
+void Command::setPending(bool pending) const {
+	if (pending == m_isPending) {
+		return;
+	}
+
+	m_isPending = pending;
+	m_device.setCommandPending(m_queue, pending);
+}
+
+StagingAllocation Command::stageData(const void* data, VkDeviceSize size) {
+	StagingAllocation staging = m_device.allocateStaging(size);
+
+	if (staging.buffer != nullptr) {
+		memcpy(staging.mappedData, data, size);
+		m_stagingAllocations.push_back(staging);
+		return staging;
+	}
+
+	// the ring is full (or disabled), fall back to a dedicated buffer
+	auto buffer =
+		std::make_unique<Buffer>(m_device.createStagingBuffer(size, data));
+
+	staging = {
+		.buffer = buffer->getHandle(),
+		.offset = 0,
+		.size = size,
+		.mappedData = buffer->getMappedPointer(),
+	};
+
+	m_stagingBuffers.push_back(std::move(buffer));
+
+	return staging;
+}
+
+void Command::releaseStaging() {
+	for (const auto& allocation : m_stagingAllocations) {
+		m_device.releaseStaging(allocation);
+	}
+
+	m_stagingAllocations.clear();
+	m_stagingBuffers.clear();
+}
+
 void Command::transitionImageLayout(Image& image, VkImageLayout newLayout) {
 	CHECK_IS_RECORDING;
 
@@ -98,6 +250,217 @@ void Command::transitionToOptimalLayout(ImageId imageId) {
 	transitionToOptimalLayout(image);
 }
 
+void Command::memoryBarrier(VkPipelineStageFlags2 srcStage,
+							VkAccessFlags2 srcAccess,
+							VkPipelineStageFlags2 dstStage,
+							VkAccessFlags2 dstAccess) {
+	CHECK_IS_RECORDING;
+
+	VkMemoryBarrier2 const barrier{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+		.srcStageMask = srcStage,
+		.srcAccessMask = srcAccess,
+		.dstStageMask = dstStage,
+		.dstAccessMask = dstAccess,
+	};
+
+	VkDependencyInfo const dependencyInfo{
+		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		.memoryBarrierCount = 1,
+		.pMemoryBarriers = &barrier,
+	};
+
+	vkCmdPipelineBarrier2(m_commandBuffer, &dependencyInfo);
+}
+
+void Command::bufferBarrier(const Buffer& buffer,
+							VkPipelineStageFlags2 srcStage,
+							VkAccessFlags2 srcAccess,
+							VkPipelineStageFlags2 dstStage,
+							VkAccessFlags2 dstAccess,
+							VkDeviceSize offset,
+							VkDeviceSize size) {
+	CHECK_IS_RECORDING;
+
+	VkBufferMemoryBarrier2 const barrier{
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+		.srcStageMask = srcStage,
+		.srcAccessMask = srcAccess,
+		.dstStageMask = dstStage,
+		.dstAccessMask = dstAccess,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.buffer = buffer.getHandle(),
+		.offset = offset,
+		.size = size,
+	};
+
+	VkDependencyInfo const dependencyInfo{
+		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		.bufferMemoryBarrierCount = 1,
+		.pBufferMemoryBarriers = &barrier,
+	};
+
+	vkCmdPipelineBarrier2(m_commandBuffer, &dependencyInfo);
+}
+
+void Command::bufferBarrier(BufferId bufferId,
+							VkPipelineStageFlags2 srcStage,
+							VkAccessFlags2 srcAccess,
+							VkPipelineStageFlags2 dstStage,
+							VkAccessFlags2 dstAccess,
+							VkDeviceSize offset,
+							VkDeviceSize size) {
+	auto& buffer = m_device.getBuffer(bufferId);
+
+	bufferBarrier(buffer, srcStage, srcAccess, dstStage, dstAccess, offset, size);
+}
+
+void Command::imageBarrier(const Image& image,
+						   VkPipelineStageFlags2 srcStage,
+						   VkAccessFlags2 srcAccess,
+						   VkPipelineStageFlags2 dstStage,
+						   VkAccessFlags2 dstAccess) {
+	CHECK_IS_RECORDING;
+
+	VkImageMemoryBarrier2 const barrier{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+		.srcStageMask = srcStage,
+		.srcAccessMask = srcAccess,
+		.dstStageMask = dstStage,
+		.dstAccessMask = dstAccess,
+		.oldLayout = image.m_currentLayout,
+		.newLayout = image.m_currentLayout,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = image.getHandle(),
+		.subresourceRange = {image.getAspect(), 0, 1, 0, 1},
+	};
+
+	VkDependencyInfo const dependencyInfo{
+		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		.imageMemoryBarrierCount = 1,
+		.pImageMemoryBarriers = &barrier,
+	};
+
+	vkCmdPipelineBarrier2(m_commandBuffer, &dependencyInfo);
+}
+
+void Command::imageBarrier(ImageId imageId,
+						   VkPipelineStageFlags2 srcStage,
+						   VkAccessFlags2 srcAccess,
+						   VkPipelineStageFlags2 dstStage,
+						   VkAccessFlags2 dstAccess) {
+	auto& image = m_device.getImage(imageId);
+
+	imageBarrier(image, srcStage, srcAccess, dstStage, dstAccess);
+}
+
+void Command::releaseBuffer(const Buffer& buffer,
+							VkQueue dstQueue,
+							VkPipelineStageFlags2 srcStage,
+							VkAccessFlags2 srcAccess) {
+	ownershipBarrier(buffer, m_device.getQueueFamilyIndex(m_queue),
+					 m_device.getQueueFamilyIndex(dstQueue), srcStage, srcAccess);
+}
+
+void Command::acquireBuffer(const Buffer& buffer,
+							VkQueue srcQueue,
+							VkPipelineStageFlags2 dstStage,
+							VkAccessFlags2 dstAccess) {
+	ownershipBarrier(buffer, m_device.getQueueFamilyIndex(srcQueue),
+					 m_device.getQueueFamilyIndex(m_queue), dstStage, dstAccess);
+}
+
+void Command::releaseImage(const Image& image,
+						   VkQueue dstQueue,
+						   VkPipelineStageFlags2 srcStage,
+						   VkAccessFlags2 srcAccess) {
+	ownershipBarrier(image, m_device.getQueueFamilyIndex(m_queue),
+					 m_device.getQueueFamilyIndex(dstQueue), srcStage, srcAccess);
+}
+
+void Command::acquireImage(const Image& image,
+						   VkQueue srcQueue,
+						   VkPipelineStageFlags2 dstStage,
+						   VkAccessFlags2 dstAccess) {
+	ownershipBarrier(image, m_device.getQueueFamilyIndex(srcQueue),
+					 m_device.getQueueFamilyIndex(m_queue), dstStage, dstAccess);
+}
+
+// the release only uses the source scope and the acquire only the destination
+// one, the other half is ignored by the driver
+void Command::ownershipBarrier(const Buffer& buffer,
+							   uint32_t srcFamily,
+							   uint32_t dstFamily,
+							   VkPipelineStageFlags2 stage,
+							   VkAccessFlags2 access) {
+	CHECK_IS_RECORDING;
+
+	if (srcFamily == dstFamily) {
+		return;
+	}
+
+	const bool isRelease = srcFamily == m_device.getQueueFamilyIndex(m_queue);
+
+	VkBufferMemoryBarrier2 const barrier{
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+		.srcStageMask = isRelease ? stage : VK_PIPELINE_STAGE_2_NONE,
+		.srcAccessMask = isRelease ? access : VK_ACCESS_2_NONE,
+		.dstStageMask = isRelease ? VK_PIPELINE_STAGE_2_NONE : stage,
+		.dstAccessMask = isRelease ? VK_ACCESS_2_NONE : access,
+		.srcQueueFamilyIndex = srcFamily,
+		.dstQueueFamilyIndex = dstFamily,
+		.buffer = buffer.getHandle(),
+		.offset = 0,
+		.size = VK_WHOLE_SIZE,
+	};
+
+	VkDependencyInfo const dependencyInfo{
+		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		.bufferMemoryBarrierCount = 1,
+		.pBufferMemoryBarriers = &barrier,
+	};
+
+	vkCmdPipelineBarrier2(m_commandBuffer, &dependencyInfo);
+}
+
+void Command::ownershipBarrier(const Image& image,
+							   uint32_t srcFamily,
+							   uint32_t dstFamily,
+							   VkPipelineStageFlags2 stage,
+							   VkAccessFlags2 access) {
+	CHECK_IS_RECORDING;
+
+	if (srcFamily == dstFamily) {
+		return;
+	}
+
+	const bool isRelease = srcFamily == m_device.getQueueFamilyIndex(m_queue);
+
+	VkImageMemoryBarrier2 const barrier{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+		.srcStageMask = isRelease ? stage : VK_PIPELINE_STAGE_2_NONE,
+		.srcAccessMask = isRelease ? access : VK_ACCESS_2_NONE,
+		.dstStageMask = isRelease ? VK_PIPELINE_STAGE_2_NONE : stage,
+		.dstAccessMask = isRelease ? VK_ACCESS_2_NONE : access,
+		.oldLayout = image.m_currentLayout,
+		.newLayout = image.m_currentLayout,
+		.srcQueueFamilyIndex = srcFamily,
+		.dstQueueFamilyIndex = dstFamily,
+		.image = image.getHandle(),
+		.subresourceRange = {image.getAspect(), 0, 1, 0, 1},
+	};
+
+	VkDependencyInfo const dependencyInfo{
+		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		.imageMemoryBarrierCount = 1,
+		.pImageMemoryBarriers = &barrier,
+	};
+
+	vkCmdPipelineBarrier2(m_commandBuffer, &dependencyInfo);
+}
+
 void Command::copyImage(const Image& src,
 						const Image& dst,
 						VkOffset2D srcOffset,
@@ -222,22 +585,20 @@ void Command::updateImage(const Image& image,
 		imageSize.height = image.getExtent2D().height;
 	}
 
-	auto staging = std::make_unique<Buffer>(
-		m_device.createStagingBuffer(image.getSize(), pixels));
+	const VkDeviceSize regionSize = static_cast<VkDeviceSize>(imageSize.width) *
+									imageSize.height * image.getPixelSize();
 
-	staging->writeData(pixels);
+	StagingAllocation staging = stageData(pixels, regionSize);
 
 	VkBufferImageCopy const copyRegion{
-		.bufferOffset = 0,
+		.bufferOffset = staging.offset,
 		.imageSubresource = {image.getAspect(), 0, 0, 1},
 		.imageOffset = {imageOffset.x, imageOffset.y, 0},
 		.imageExtent = {imageSize.width, imageSize.height, 1},
 	};
 
-	vkCmdCopyBufferToImage(m_commandBuffer, staging->getHandle(), image.getHandle(),
+	vkCmdCopyBufferToImage(m_commandBuffer, staging.buffer, image.getHandle(),
 						   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
-
-	m_stagingBuffers.push_back(std::move(staging));
 }
 
 void Command::updateImage(ImageId imageId,
@@ -282,19 +643,16 @@ void Command::updateBuffer(const Buffer& buffer,
 
 	THROW_ERROR(offset + size > buffer.getSize(), "Out of bounds");
 
-	auto staging =
-		std::make_unique<Buffer>(m_device.createStagingBuffer(size, data));
+	StagingAllocation staging = stageData(data, size);
 
 	VkBufferCopy const copyRegion{
-		.srcOffset = 0,
+		.srcOffset = staging.offset,
 		.dstOffset = offset,
 		.size = size,
 	};
 
-	vkCmdCopyBuffer(m_commandBuffer, staging->getHandle(), buffer.getHandle(), 1,
+	vkCmdCopyBuffer(m_commandBuffer, staging.buffer, buffer.getHandle(), 1,
 					&copyRegion);
-
-	m_stagingBuffers.push_back(std::move(staging));
 }
 
 void Command::updateBuffer(BufferId bufferId,
@@ -308,22 +666,103 @@ void Command::updateBuffer(BufferId bufferId,
 void Command::bindPipeline(const Pipeline& pipeline) {
 	CHECK_IS_RECORDING;
 
+	bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, m_state.graphics,
+				 pipeline.getHandle(), pipeline.getLayoutHandle());
+
+	m_pipelineBound = true;
+}
+
+void Command::bindPipeline(const ComputePipeline& pipeline) {
+	CHECK_IS_RECORDING;
+
+	bindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, m_state.compute,
+				 pipeline.getHandle(), pipeline.getLayoutHandle());
+
+	m_computePipelineBound = true;
+}
+
+void Command::bindPipeline(VkPipelineBindPoint bindPoint,
+						   BindPointState& state,
+						   VkPipeline pipeline,
+						   VkPipelineLayout layout) {
 	VkDescriptorSet descriptorSet = m_device.getDescriptorSet();
 
-	vkCmdBindDescriptorSets(m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-							pipeline.getLayoutHandle(), 0, 1, &descriptorSet, 0,
-							nullptr);
+	// layouts differ in their push constant range, so a set bound with another
+	// layout is not compatible
+	if (layout == state.layout && descriptorSet == state.descriptorSet) {
+		m_elidedCalls.descriptorSets++;
+	} else {
+		vkCmdBindDescriptorSets(m_commandBuffer, bindPoint, layout, 0, 1,
+								&descriptorSet, 0, nullptr);
 
-	vkCmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-					  pipeline.getHandle());
+		state.layout = layout;
+		state.descriptorSet = descriptorSet;
+	}
 
-	m_pipelineBound = true;
+	if (layout != m_state.pushConstantLayout) {
+		m_state.pushConstantMask = 0;
+	}
+
+	if (pipeline == state.pipeline) {
+		m_elidedCalls.pipelines++;
+	} else {
+		vkCmdBindPipeline(m_commandBuffer, bindPoint, pipeline);
+
+		state.pipeline = pipeline;
+	}
+}
+
+void Command::pushConstantData(VkPipelineLayout layout,
+							   const void* data,
+							   uint32_t offset,
+							   uint32_t size) {
+	const uint32_t firstWord = offset / 4;
+	const uint32_t wordCount = size / 4;
+
+	const bool cacheable = offset % 4 == 0 &&
+						   firstWord + wordCount <= m_state.pushConstants.size();
+
+	if (layout != m_state.pushConstantLayout) {
+		m_state.pushConstantLayout = layout;
+		m_state.pushConstantMask = 0;
+	}
+
+	if (cacheable) {
+		const uint32_t mask = wordCount == 32
+								  ? UINT32_MAX
+								  : ((1u << wordCount) - 1) << firstWord;
+
+		uint32_t* cached = m_state.pushConstants.data() + firstWord;
+
+		if ((m_state.pushConstantMask & mask) == mask &&
+			memcmp(cached, data, size) == 0) {
+			m_elidedCalls.pushConstants++;
+			return;
+		}
+
+		memcpy(cached, data, size);
+		m_state.pushConstantMask |= mask;
+	}
+
+	vkCmdPushConstants(m_commandBuffer, layout, VK_SHADER_STAGE_ALL, offset, size,
+					   data);
+}
+
+void Command::invalidateState() {
+	m_state = {};
 }
 
 void Command::beginRender(const DrawAttachment* drawAttachment,
-						  const DepthAttachment* depthAttachment) {
+						  const DepthAttachment* depthAttachment,
+						  VkRenderingFlags flags) {
 	CHECK_IS_RECORDING;
 
+	assert(!isSecondary() && "Secondary commands inherit the render");
+
+	assert(m_device.getQueueFamilyIndex(m_queue) ==
+			   m_device.getGraphicsFamilyIndex() &&
+		   "Only commands on graphics queues can render");
+
 	assert(drawAttachment != nullptr ||
 		   depthAttachment != nullptr && "Both attachments are nullptr");
 
@@ -390,6 +829,7 @@ void Command::beginRender(const DrawAttachment* drawAttachment,
 
 	VkRenderingInfo const renderingInfo{
 		.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+		.flags = flags,
 		.renderArea = {{0, 0}, extent},
 		.layerCount = 1,
 		.colorAttachmentCount = drawAttachment != nullptr ? 1u : 0,
@@ -410,7 +850,16 @@ void Command::setViewport(VkViewport viewport) {
 	CHECK_IS_RECORDING;
 	CHECK_PIPELINE_BOUND;
 
+	if (m_state.hasViewport &&
+		memcmp(&m_state.viewport, &viewport, sizeof(viewport)) == 0) {
+		m_elidedCalls.viewports++;
+		return;
+	}
+
 	vkCmdSetViewport(m_commandBuffer, 0, 1, &viewport);
+
+	m_state.viewport = viewport;
+	m_state.hasViewport = true;
 }
 
 void Command::clearViewport(float x,
@@ -446,7 +895,16 @@ void Command::setScissor(uint32_t width, uint32_t height, uint32_t x, uint32_t y
 		.extent = {width, height},
 	};
 
+	if (m_state.hasScissor &&
+		memcmp(&m_state.scissor, &scissor, sizeof(scissor)) == 0) {
+		m_elidedCalls.scissors++;
+		return;
+	}
+
 	vkCmdSetScissor(m_commandBuffer, 0, 1, &scissor);
+
+	m_state.scissor = scissor;
+	m_state.hasScissor = true;
 }
 
 void Command::bindIndexBuffer(const Buffer& indexBuffer, VkDeviceSize offset) {
@@ -460,8 +918,51 @@ void Command::bindIndexBuffer(const Buffer& indexBuffer, VkDeviceSize offset) {
 								? VK_INDEX_TYPE_UINT32
 								: VK_INDEX_TYPE_UINT16;
 
+	if (indexBuffer.getHandle() == m_state.indexBuffer &&
+		offset == m_state.indexOffset && indexType == m_state.indexType) {
+		m_elidedCalls.indexBuffers++;
+		return;
+	}
+
 	vkCmdBindIndexBuffer(m_commandBuffer, indexBuffer.getHandle(), offset,
 						 indexType);
+
+	m_state.indexBuffer = indexBuffer.getHandle();
+	m_state.indexOffset = offset;
+	m_state.indexType = indexType;
+}
+
+void Command::executeSecondary(std::span<const Command* const> commands) {
+	CHECK_IS_RECORDING;
+
+	assert(!isSecondary() && "Secondary commands can't be nested");
+
+	// batched on the stack, one vkCmdExecuteCommands per batch
+	std::array<VkCommandBuffer, 64> handles;
+
+	for (size_t first = 0; first < commands.size(); first += handles.size()) {
+		const size_t count = std::min(handles.size(), commands.size() - first);
+
+		for (size_t i = 0; i < count; i++) {
+			const Command* command = commands[first + i];
+
+			assert(command->isSecondary() && !command->m_isRecording &&
+				   "Only ended secondary commands can be executed");
+
+			handles[i] = command->m_commandBuffer;
+
+			// this command is pending until its own submission
+			command->setPending(false);
+		}
+
+		vkCmdExecuteCommands(m_commandBuffer, static_cast<uint32_t>(count),
+							 handles.data());
+	}
+
+	// the state of the command is undefined after executing secondary ones
+	invalidateState();
+	m_pipelineBound = false;
+	m_computePipelineBound = false;
 }
 
 void Command::draw(uint32_t indexCount, uint32_t firstVertex) {
@@ -481,3 +982,28 @@ void Command::drawInstanced(uint32_t indexCount,
 	vkCmdDrawIndexed(m_commandBuffer, indexCount, instanceCount, firstIndex, 0,
 					 firstInstance);
 }
+
+void Command::dispatch(uint32_t groupCountX,
+					   uint32_t groupCountY,
+					   uint32_t groupCountZ) {
+	CHECK_IS_RECORDING;
+	CHECK_COMPUTE_PIPELINE_BOUND;
+
+	vkCmdDispatch(m_commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+void Command::dispatchIndirect(const Buffer& buffer, VkDeviceSize offset) {
+	CHECK_IS_RECORDING;
+	CHECK_COMPUTE_PIPELINE_BOUND;
+
+	assert((buffer.getUsage() & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) != 0 &&
+		   "Buffer is not an indirect buffer");
+
+	vkCmdDispatchIndirect(m_commandBuffer, buffer.getHandle(), offset);
+}
+
+void Command::dispatchIndirect(BufferId bufferId, VkDeviceSize offset) {
+	auto& buffer = m_device.getBuffer(bufferId);
+
+	dispatchIndirect(buffer, offset);
+}
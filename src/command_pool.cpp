@@ -0,0 +1,86 @@
+#include <cassert>
+#include "ignis/command_pool.hpp"
+#include "ignis/command.hpp"
+#include "ignis/device.hpp"
+#include "exceptions.hpp"
+
+using namespace ignis;
+
+CommandPool::CommandPool(const CommandPoolCreateInfo& info)
+	: m_device(info.device),
+	  m_queue(info.queue != nullptr ? info.queue : m_device.getQueue(0)),
+	  m_blockSize(info.blockSize) {
+	assert(m_blockSize > 0 && "Invalid block size");
+
+	// no per-buffer reset, buffers go back to the initial state with the pool
+	VkCommandPoolCreateInfo const poolInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+		.queueFamilyIndex = m_device.getQueueFamilyIndex(m_queue),
+	};
+
+	THROW_VULKAN_ERROR(vkCreateCommandPool(m_device.getDevice(), &poolInfo,
+										   nullptr, &m_commandPool),
+					   "Failed to create command pool");
+}
+
+CommandPool::~CommandPool() {
+	m_primary.commands.clear();
+	m_secondary.commands.clear();
+
+	// frees every command buffer of the pool
+	vkDestroyCommandPool(m_device.getDevice(), m_commandPool, nullptr);
+}
+
+Command& CommandPool::acquire(VkCommandBufferLevel level) {
+	Commands& commands =
+		level == VK_COMMAND_BUFFER_LEVEL_PRIMARY ? m_primary : m_secondary;
+
+	if (commands.used == commands.commands.size()) {
+		allocateBlock(commands, level);
+	}
+
+	return *commands.commands[commands.used++];
+}
+
+void CommandPool::reset() {
+	for (Commands* commands : {&m_primary, &m_secondary}) {
+		for (uint32_t i = 0; i < commands->used; i++) {
+			Command& command = *commands->commands[i];
+
+			assert(!command.m_isRecording && "Command is still recording");
+
+			// begun but never submitted
+			command.setPending(false);
+			command.releaseStaging();
+		}
+
+		commands->used = 0;
+	}
+
+	THROW_VULKAN_ERROR(vkResetCommandPool(m_device.getDevice(), m_commandPool, 0),
+					   "Failed to reset command pool");
+}
+
+void CommandPool::allocateBlock(Commands& commands, VkCommandBufferLevel level) {
+	std::vector<VkCommandBuffer> commandBuffers(m_blockSize);
+
+	VkCommandBufferAllocateInfo const allocInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+		.commandPool = m_commandPool,
+		.level = level,
+		.commandBufferCount = m_blockSize,
+	};
+
+	THROW_VULKAN_ERROR(vkAllocateCommandBuffers(m_device.getDevice(), &allocInfo,
+												commandBuffers.data()),
+					   "Failed to allocate command buffers");
+
+	commands.commands.reserve(commands.commands.size() + m_blockSize);
+
+	for (auto commandBuffer : commandBuffers) {
+		// the constructor is private, make_unique can't call it
+		commands.commands.emplace_back(
+			new Command(m_device, m_queue, commandBuffer, level));
+	}
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cassert>
 #include <cstring>
 #include <iostream>
 #include "ignis/device.hpp"
@@ -9,8 +11,11 @@
 #include "ignis/sampler.hpp"
 #include "ignis/swapchain.hpp"
 #include "gpu_resources.hpp"
+#include "staging_ring.hpp"
+#include "pipeline_cache.hpp"
 #include "features.hpp"
 #include "exceptions.hpp"
+#include "trace.hpp"
 
 #define VMA_IMPLEMENTATION
 #include "vk_mem_alloc.h"
@@ -120,27 +125,76 @@ static void getGraphicsFamily(VkPhysicalDevice device,
 	}
 }
 
-static void createLogicalDevice(VkPhysicalDevice physicalDevice,
-								uint32_t graphicsQueuesCount,
-								uint32_t graphicsFamilyIndex,
-								const std::vector<const char*>& extensions,
-								VkPhysicalDeviceFeatures2 features,
-								std::vector<VkQueue>* queues,
-								VkDevice* device) {
-	std::vector<float> priorities(graphicsQueuesCount, 1.0f);
+static bool getTransferFamily(VkPhysicalDevice device,
+							  uint32_t* transferFamilyIndex) {
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
 
-	VkDeviceQueueCreateInfo queueCreateInfo{
-		.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-		.queueFamilyIndex = graphicsFamilyIndex,
-		.queueCount = graphicsQueuesCount,
-		.pQueuePriorities = priorities.data(),
-	};
+	std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount,
+											 queueFamilyProperties.data());
+
+	// prefer a transfer only family (copy engine)
+	for (uint32_t i = 0; i < queueFamilyCount; i++) {
+		const VkQueueFlags flags = queueFamilyProperties[i].queueFlags;
+
+		if ((flags & VK_QUEUE_TRANSFER_BIT) &&
+			!(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			*transferFamilyIndex = i;
+			return true;
+		}
+	}
+
+	// then an async compute family, which always supports transfers
+	for (uint32_t i = 0; i < queueFamilyCount; i++) {
+		const VkQueueFlags flags = queueFamilyProperties[i].queueFlags;
 
+		if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+			*transferFamilyIndex = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// a family with compute but no graphics, its queues run next to the graphics ones
+static bool getComputeFamily(VkPhysicalDevice device,
+							 uint32_t* computeQueuesCount,
+							 uint32_t* computeFamilyIndex) {
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+
+	std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount,
+											 queueFamilyProperties.data());
+
+	for (uint32_t i = 0; i < queueFamilyCount; i++) {
+		const VkQueueFlags flags = queueFamilyProperties[i].queueFlags;
+
+		if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+			*computeFamilyIndex = i;
+			*computeQueuesCount = queueFamilyProperties[i].queueCount;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void createLogicalDevice(
+	VkPhysicalDevice physicalDevice,
+	const std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos,
+	const std::vector<const char*>& extensions,
+	VkPhysicalDeviceFeatures2 features,
+	VkDevice* device) {
 	VkDeviceCreateInfo createInfo{
 		.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
 		.pNext = &features,
-		.queueCreateInfoCount = 1,
-		.pQueueCreateInfos = &queueCreateInfo,
+		.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
+		.pQueueCreateInfos = queueCreateInfos.data(),
 		.enabledExtensionCount = static_cast<uint32_t>(extensions.size()),
 		.ppEnabledExtensionNames = extensions.data(),
 		.pEnabledFeatures = nullptr,
@@ -148,10 +202,15 @@ static void createLogicalDevice(VkPhysicalDevice physicalDevice,
 
 	THROW_VULKAN_ERROR(vkCreateDevice(physicalDevice, &createInfo, nullptr, device),
 					   "Failed to create logical device");
+}
 
-	for (uint32_t i = 0; i < graphicsQueuesCount; i++) {
+static void getDeviceQueues(VkDevice device,
+							uint32_t familyIndex,
+							uint32_t queuesCount,
+							std::vector<VkQueue>* queues) {
+	for (uint32_t i = 0; i < queuesCount; i++) {
 		VkQueue queue = nullptr;
-		vkGetDeviceQueue(*device, graphicsFamilyIndex, i, &queue);
+		vkGetDeviceQueue(device, familyIndex, i, &queue);
 		queues->push_back(queue);
 	}
 }
@@ -171,28 +230,76 @@ static void createAllocator(VkDevice device,
 					   "Failed to create allocator");
 }
 
+static VkCommandPool createCommandPool(VkDevice device, uint32_t familyIndex) {
+	VkCommandPoolCreateInfo poolInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+		.queueFamilyIndex = familyIndex,
+	};
+
+	VkCommandPool commandPool = nullptr;
+	THROW_VULKAN_ERROR(vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool),
+					   "Failed to create command pool");
+
+	return commandPool;
+}
+
 static void allocateCommandPools(
 	VkDevice device,
-	uint32_t graphicsFamilyIndex,
-	const std::vector<VkQueue>& graphicsQueues,
+	uint32_t familyIndex,
+	const std::vector<VkQueue>& queues,
 	std::unordered_map<VkQueue, VkCommandPool>* commandPools) {
-	for (const auto& queue : graphicsQueues) {
-		VkCommandPoolCreateInfo poolInfo{
-			.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-			.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-			.queueFamilyIndex = graphicsFamilyIndex,
-		};
+	for (const auto& queue : queues) {
+		commandPools->insert({queue, createCommandPool(device, familyIndex)});
+	}
+}
+
+// every pool created by acquireCommandPool, the device destroys them; exiting
+// threads hand theirs back as free pools for the next threads to reuse
+struct ignis::ThreadCommandPoolList {
+	std::mutex mutex;
+	std::vector<VkCommandPool> pools;
+	std::vector<std::pair<uint32_t, VkCommandPool>> freePools;  // by family
+};
+
+// the pools of the calling thread, device ids are never reused so entries of
+// destroyed devices can't match
+struct ThreadCommandPool {
+	uint64_t deviceId;
+	uint32_t familyIndex;
+	uint32_t frame;
+	VkCommandPool commandPool;
+	std::weak_ptr<ThreadCommandPoolList> owner;
+};
+
+struct ThreadCommandPools {
+	std::vector<ThreadCommandPool> entries;
+
+	// the list is gone if the device was destroyed first, with its pools
+	~ThreadCommandPools() {
+		for (const auto& entry : entries) {
+			auto list = entry.owner.lock();
+
+			if (list == nullptr)
+				continue;
 
-		VkCommandPool commandPool = nullptr;
-		THROW_VULKAN_ERROR(
-			vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool),
-			"Failed to create command pool");
+			std::lock_guard lock(list->mutex);
+			list->freePools.push_back({entry.familyIndex, entry.commandPool});
+		}
+	}
+};
+
+static thread_local ThreadCommandPools t_commandPools;
 
-		commandPools->insert({queue, commandPool});
+static std::atomic<uint64_t> s_nextDeviceId{0};
+
+Device::Device(const CreateInfo& createInfo)
+	: m_threadCommandPools(std::make_shared<ThreadCommandPoolList>()),
+	  m_id(s_nextDeviceId++) {
+	if (!createInfo.traceFile.empty()) {
+		trace::start(createInfo.traceFile);
 	}
-}
 
-Device::Device(const CreateInfo& createInfo) {
 	createInstance(createInfo.appName, createInfo.instanceExtensions, &m_instance);
 
 #ifndef NDEBUG
@@ -205,7 +312,7 @@ Device::Device(const CreateInfo& createInfo) {
 		requiredFeatures.push_back(reqFeature);
 	}
 
-	auto m_features =
+	m_features =
 		std::make_unique<Features>(requiredFeatures, createInfo.optionalFeatures);
 
 	m_features->pickPhysicalDevice(m_instance, createInfo.extensions,
@@ -214,14 +321,117 @@ Device::Device(const CreateInfo& createInfo) {
 	getGraphicsFamily(m_phyiscalDevice, &m_graphicsQueuesCount,
 					  &m_graphicsFamilyIndex);
 
-	createLogicalDevice(m_phyiscalDevice, m_graphicsQueuesCount,
-						m_graphicsFamilyIndex, createInfo.extensions,
-						m_features->getFeatures(), &m_queues, &m_device);
+	// the queue timelines fit in a QueueValues with the transfer queue
+	m_graphicsQueuesCount = std::min(m_graphicsQueuesCount, MAX_QUEUES / 2);
+
+	const bool hasTransferFamily =
+		getTransferFamily(m_phyiscalDevice, &m_transferFamilyIndex);
+
+	uint32_t computeFamilyQueuesCount{0};
+
+	const bool hasComputeFamily = getComputeFamily(
+		m_phyiscalDevice, &computeFamilyQueuesCount, &m_computeFamilyIndex);
+
+	// without a transfer only family the transfer queue is the last queue of
+	// the compute family, the compute queues are the ones before it
+	const bool sharesComputeFamily = hasComputeFamily && hasTransferFamily &&
+									 m_transferFamilyIndex == m_computeFamilyIndex;
+
+	const uint32_t transferQueueIndex =
+		sharesComputeFamily ? computeFamilyQueuesCount - 1 : 0;
+
+	const uint32_t computeQueuesCount =
+		std::min(sharesComputeFamily ? computeFamilyQueuesCount - 1
+									 : computeFamilyQueuesCount,
+				 MAX_QUEUES / 2 - 1);
+
+	std::vector<float> priorities(
+		std::max(m_graphicsQueuesCount, computeFamilyQueuesCount), 1.0f);
+
+	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos{{
+		.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+		.queueFamilyIndex = m_graphicsFamilyIndex,
+		.queueCount = m_graphicsQueuesCount,
+		.pQueuePriorities = priorities.data(),
+	}};
+
+	if (hasTransferFamily && !sharesComputeFamily) {
+		queueCreateInfos.push_back({
+			.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+			.queueFamilyIndex = m_transferFamilyIndex,
+			.queueCount = 1,
+			.pQueuePriorities = priorities.data(),
+		});
+	}
+
+	if (hasComputeFamily) {
+		queueCreateInfos.push_back({
+			.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+			.queueFamilyIndex = m_computeFamilyIndex,
+			.queueCount = computeFamilyQueuesCount,
+			.pQueuePriorities = priorities.data(),
+		});
+	}
+
+	createLogicalDevice(m_phyiscalDevice, queueCreateInfos, createInfo.extensions,
+						m_features->getFeatures(), &m_device);
+
+	getDeviceQueues(m_device, m_graphicsFamilyIndex, m_graphicsQueuesCount,
+					&m_queues);
+
+	if (hasTransferFamily) {
+		vkGetDeviceQueue(m_device, m_transferFamilyIndex, transferQueueIndex,
+						 &m_transferQueue);
+	} else {
+		m_transferFamilyIndex = m_graphicsFamilyIndex;
+		m_transferQueue = m_queues.back();
+	}
+
+	if (computeQueuesCount > 0) {
+		getDeviceQueues(m_device, m_computeFamilyIndex, computeQueuesCount,
+						&m_computeQueues);
+	} else {
+		m_computeFamilyIndex = m_graphicsFamilyIndex;
+		m_computeQueues = {m_queues.back()};
+	}
 
 	createAllocator(m_device, m_phyiscalDevice, m_instance, &m_allocator);
 
 	allocateCommandPools(m_device, m_graphicsFamilyIndex, m_queues, &m_commandPools);
 
+	if (hasTransferFamily) {
+		allocateCommandPools(m_device, m_transferFamilyIndex, {m_transferQueue},
+							 &m_commandPools);
+	}
+
+	if (hasDedicatedComputeQueue()) {
+		allocateCommandPools(m_device, m_computeFamilyIndex, m_computeQueues,
+							 &m_commandPools);
+	}
+
+	for (auto queue : m_queues) {
+		m_queueTimelines.emplace_back().queue = queue;
+	}
+
+	if (hasTransferFamily) {
+		m_queueTimelines.emplace_back().queue = m_transferQueue;
+	}
+
+	if (hasDedicatedComputeQueue()) {
+		for (auto queue : m_computeQueues) {
+			m_queueTimelines.emplace_back().queue = queue;
+		}
+	}
+
+	for (auto& timeline : m_queueTimelines) {
+		timeline.semaphore = std::make_unique<TimelineSemaphore>(m_device);
+	}
+
+	if (createInfo.stagingRingSize > 0) {
+		m_stagingRing =
+			std::make_unique<StagingRing>(m_allocator, createInfo.stagingRingSize);
+	}
+
 	BindlessResourcesCreateInfo const bindlessResourcesCreateInfo{
 		.device = m_device,
 		.maxStorageBuffers =
@@ -230,25 +440,62 @@ Device::Device(const CreateInfo& createInfo) {
 			m_physicalDeviceProperties.limits.maxPerStageDescriptorUniformBuffers,
 		.maxImageSamplers =
 			m_physicalDeviceProperties.limits.maxPerStageDescriptorSampledImages,
+		.maxStorageImages =
+			m_physicalDeviceProperties.limits.maxPerStageDescriptorStorageImages,
 		.storageBuffersBinding = IGNIS_STORAGE_BUFFER_BINDING,
 		.uniformBuffersBinding = IGNIS_UNIFORM_BUFFER_BINDING,
 		.imageSamplersBinding = IGNIS_IMAGE_SAMPLER_BINDING,
+		.storageImagesBinding = IGNIS_STORAGE_IMAGE_BINDING,
 	};
 
 	m_gpuResources = std::make_unique<GpuResources>(bindlessResourcesCreateInfo);
+
+	m_pipelineCache = std::make_unique<PipelineCache>(
+		m_device, m_physicalDeviceProperties, createInfo.pipelineCacheFile);
 }
 
 Device::~Device() {
+	trace::stop();
+
 	vkDeviceWaitIdle(m_device);
 
 	m_gpuResources.reset();
 
+	m_stagingRing.reset();
+
+	// the destructor can't throw, a failed save only costs a slower next start
+	if (!m_pipelineCache->save()) {
+		std::cerr << "ignis: failed to save the pipeline cache" << std::endl;
+	}
+
+	m_pipelineCache.reset();
+
+	m_samplers.clear();
+
+	m_pipelines.clear();
+
 	for (auto queue : m_queues)
 		vkQueueWaitIdle(queue);
 
+	if (hasDedicatedTransferQueue())
+		vkQueueWaitIdle(m_transferQueue);
+
+	if (hasDedicatedComputeQueue()) {
+		for (auto queue : m_computeQueues)
+			vkQueueWaitIdle(queue);
+	}
+
 	for (const auto& [_, commandPool] : m_commandPools)
 		vkDestroyCommandPool(m_device, commandPool, nullptr);
 
+	{
+		std::lock_guard lock(m_threadCommandPools->mutex);
+		for (auto commandPool : m_threadCommandPools->pools)
+			vkDestroyCommandPool(m_device, commandPool, nullptr);
+	}
+
+	m_queueTimelines.clear();
+
 	vmaDestroyAllocator(m_allocator);
 
 	vkDestroyDevice(m_device, nullptr);
@@ -268,6 +515,24 @@ VkQueue Device::getQueue(uint32_t index) const {
 	return m_queues[index];
 }
 
+VkQueue Device::getComputeQueue(uint32_t index) const {
+	THROW_ERROR(index >= m_computeQueues.size(), "Invalid compute queue index");
+	return m_computeQueues[index];
+}
+
+uint32_t Device::getQueueFamilyIndex(VkQueue queue) const {
+	if (queue == m_transferQueue) {
+		return m_transferFamilyIndex;
+	}
+
+	if (std::find(m_computeQueues.begin(), m_computeQueues.end(), queue) !=
+		m_computeQueues.end()) {
+		return m_computeFamilyIndex;
+	}
+
+	return m_graphicsFamilyIndex;
+}
+
 VkCommandPool Device::getCommandPool(VkQueue queue) const {
 	auto it = m_commandPools.find(queue);
 
@@ -276,77 +541,292 @@ VkCommandPool Device::getCommandPool(VkQueue queue) const {
 	return it->second;
 }
 
-void Device::submitCommands(std::vector<SubmitCmdInfo> submits,
-							const Fence* fence) const {
-	VkQueue queue = submits[0].command.getQueue();
+VkCommandPool Device::acquireCommandPool(VkQueue queue, uint32_t frame) const {
+	const uint32_t familyIndex = getQueueFamilyIndex(queue);
 
-#ifndef NDEBUG
-	for (const auto& submit : submits) {
-		if (submit.command.getQueue() != queue) {
-			std::cerr << "ignis::Device::submitCommands: "
-						 "commands must be relative to the same queue"
-					  << std::endl;
+	// lock free once the calling thread has created the pool
+	for (const auto& entry : t_commandPools.entries) {
+		if (entry.deviceId == m_id && entry.familyIndex == familyIndex &&
+			entry.frame == frame) {
+			return entry.commandPool;
 		}
 	}
-#endif
 
-	struct SubmissionData {
-		VkSubmitInfo2 submitInfo{};
-		std::vector<VkSemaphoreSubmitInfo> waitInfos;
-		std::vector<VkSemaphoreSubmitInfo> signalInfos;
-		VkCommandBufferSubmitInfo commandInfo{};
-	};
+	std::erase_if(t_commandPools.entries,
+				  [](const auto& entry) { return entry.owner.expired(); });
+
+	VkCommandPool commandPool = nullptr;
+
+	{
+		std::lock_guard lock(m_threadCommandPools->mutex);
+
+		auto& freePools = m_threadCommandPools->freePools;
+
+		auto it = std::find_if(freePools.begin(), freePools.end(),
+							   [familyIndex](const auto& freePool) {
+								   return freePool.first == familyIndex;
+							   });
+
+		if (it != freePools.end()) {
+			commandPool = it->second;
+			freePools.erase(it);
+		}
+	}
 
-	std::vector<SubmissionData> submissionsData;
-	submissionsData.reserve(submits.size());
+	if (commandPool != nullptr) {
+		// left by an exited thread, see Note 4
+		THROW_VULKAN_ERROR(vkResetCommandPool(m_device, commandPool, 0),
+						   "Failed to reset command pool");
+	} else {
+		commandPool = createCommandPool(m_device, familyIndex);
 
-	std::vector<VkSubmitInfo2> submitInfos;
+		std::lock_guard lock(m_threadCommandPools->mutex);
+		m_threadCommandPools->pools.push_back(commandPool);
+	}
+
+	t_commandPools.entries.push_back({
+		.deviceId = m_id,
+		.familyIndex = familyIndex,
+		.frame = frame,
+		.commandPool = commandPool,
+		.owner = m_threadCommandPools,
+	});
+
+	return commandPool;
+}
+
+void Device::resetCommandPools(uint32_t frame) const {
+	for (const auto& entry : t_commandPools.entries) {
+		if (entry.deviceId != m_id || entry.frame != frame)
+			continue;
+
+		THROW_VULKAN_ERROR(vkResetCommandPool(m_device, entry.commandPool, 0),
+						   "Failed to reset command pool");
+	}
+}
+
+uint64_t Device::submitCommands(std::vector<SubmitCmdInfo> submits,
+								const Fence* fence) const {
+	std::vector<const Command*> commands;
+	std::vector<SemaphoreSubmit> semaphores;
+	std::vector<SubmitInfo> submitInfos;
+
+	commands.reserve(submits.size());
 	submitInfos.reserve(submits.size());
 
+	size_t semaphoreCount{0};
 	for (const auto& submit : submits) {
-		SubmissionData data;
+		semaphoreCount +=
+			submit.waitSemaphores.size() + submit.signalSemaphores.size();
+	}
 
-		data.waitInfos.reserve(submit.waitSemaphores.size());
-		for (const auto& waitSemaphore : submit.waitSemaphores) {
-			data.waitInfos.push_back({
-				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
-				.semaphore = waitSemaphore->getHandle(),
-			});
+	// no reallocation, the spans below point into it
+	semaphores.reserve(semaphoreCount);
+
+	for (const auto& submit : submits) {
+		commands.push_back(&submit.command);
+
+		const size_t waitOffset = semaphores.size();
+		for (const auto* semaphore : submit.waitSemaphores) {
+			semaphores.push_back({.semaphore = semaphore->getHandle()});
+		}
+
+		const size_t signalOffset = semaphores.size();
+		for (const auto* semaphore : submit.signalSemaphores) {
+			semaphores.push_back({.semaphore = semaphore->getHandle()});
 		}
 
-		data.signalInfos.reserve(submit.signalSemaphores.size());
-		for (const auto& signalSemaphore : submit.signalSemaphores) {
-			data.signalInfos.push_back({
+		submitInfos.push_back({
+			.commands = {&commands.back(), 1},
+			.waitSemaphores = {semaphores.data() + waitOffset,
+							   submit.waitSemaphores.size()},
+			.signalSemaphores = {semaphores.data() + signalOffset,
+								 submit.signalSemaphores.size()},
+		});
+	}
+
+	return submitCommands(submitInfos, fence);
+}
+
+uint64_t Device::submitCommands(std::span<const SubmitInfo> submits,
+								const Fence* fence) const {
+	IGNIS_TRACE_SCOPE("Device::submitCommands");
+
+	THROW_ERROR(submits.empty() || submits[0].commands.empty(),
+				"Nothing to submit");
+
+	const VkQueue queue = submits[0].commands[0]->getQueue();
+
+	// everything lives on the stack, the submit path doesn't allocate
+	std::array<VkSubmitInfo2, IGNIS_MAX_SUBMITS> submitInfos;
+	std::array<VkCommandBufferSubmitInfo, IGNIS_MAX_SUBMIT_COMMANDS> commandInfos;
+	std::array<VkSemaphoreSubmitInfo, IGNIS_MAX_SUBMIT_SEMAPHORES + 1>
+		semaphoreInfos;
+
+	THROW_ERROR(submits.size() > IGNIS_MAX_SUBMITS, "Too many submits");
+
+	uint32_t commandCount{0};
+	uint32_t semaphoreCount{0};
+
+	auto pushSemaphores = [&](std::span<const SemaphoreSubmit> semaphores) {
+		THROW_ERROR(
+			semaphoreCount + semaphores.size() > IGNIS_MAX_SUBMIT_SEMAPHORES,
+			"Too many semaphores in a single submission");
+
+		for (const auto& semaphore : semaphores) {
+			semaphoreInfos[semaphoreCount++] = {
 				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
-				.semaphore = signalSemaphore->getHandle(),
-			});
+				.semaphore = semaphore.semaphore,
+				.value = semaphore.value,
+				.stageMask = semaphore.stageMask,
+			};
 		}
+	};
 
-		data.commandInfo = {
-			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
-			.commandBuffer = submit.command.getHandle(),
-		};
+	const QueueTimeline& timeline = getTimeline(queue);
+
+	// the queue may be aliased by the transfer and compute queues, see Note 2
+	std::unique_lock lock(timeline.submitMutex);
+
+	const uint64_t timelineValue = timeline.submittedValue + 1;
+
+	for (size_t i = 0; i < submits.size(); i++) {
+		const SubmitInfo& submit = submits[i];
 
-		data.submitInfo = {
+		THROW_ERROR(
+			commandCount + submit.commands.size() > IGNIS_MAX_SUBMIT_COMMANDS,
+			"Too many command buffers in a single submission");
+
+		VkSubmitInfo2& info = submitInfos[i];
+
+		info = {
 			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
-			.waitSemaphoreInfoCount = static_cast<uint32_t>(data.waitInfos.size()),
-			.pWaitSemaphoreInfos = data.waitInfos.data(),
-			.commandBufferInfoCount = 1,
-			.pCommandBufferInfos = &data.commandInfo,
-			.signalSemaphoreInfoCount =
-				static_cast<uint32_t>(data.signalInfos.size()),
-			.pSignalSemaphoreInfos = data.signalInfos.data(),
+			.waitSemaphoreInfoCount =
+				static_cast<uint32_t>(submit.waitSemaphores.size()),
+			.pWaitSemaphoreInfos = semaphoreInfos.data() + semaphoreCount,
+			.commandBufferInfoCount =
+				static_cast<uint32_t>(submit.commands.size()),
+			.pCommandBufferInfos = commandInfos.data() + commandCount,
 		};
 
-		submissionsData.push_back(std::move(data));
+		pushSemaphores(submit.waitSemaphores);
+
+		for (const Command* command : submit.commands) {
+			assert(command->getQueue() == queue &&
+				   "Commands must be relative to the same queue");
+
+			commandInfos[commandCount++] = {
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+				.commandBuffer = command->getHandle(),
+			};
+		}
+
+		info.signalSemaphoreInfoCount =
+			static_cast<uint32_t>(submit.signalSemaphores.size());
+		info.pSignalSemaphoreInfos = semaphoreInfos.data() + semaphoreCount;
+
+		pushSemaphores(submit.signalSemaphores);
+	}
+
+	// the last submission advances the queue timeline, the extra slot is its own
+	semaphoreInfos[semaphoreCount++] = {
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+		.semaphore = timeline.semaphore->getHandle(),
+		.value = timelineValue,
+		.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+	};
+
+	submitInfos[submits.size() - 1].signalSemaphoreInfoCount++;
+
+	// registrations since the last submit become visible to this one
+	m_gpuResources->flushDescriptorWrites();
+
+	THROW_VULKAN_ERROR(
+		vkQueueSubmit2(queue, static_cast<uint32_t>(submits.size()),
+					   submitInfos.data(), fence ? fence->getHandle() : nullptr),
+		"Failed to submit commands");
+
+	timeline.submittedValue = timelineValue;
+
+	lock.unlock();
+
+	// cleared once the timeline has moved on, so a concurrent destruction
+	// retires at this submission or at the next one
+	for (const auto& submit : submits) {
+		for (const Command* command : submit.commands) {
+			command->setPending(false);
+		}
+	}
+
+	// after the submit, destructions recorded before it retire at its value
+	if (m_gpuResources->hasPendingDestructions()) {
+		QueueValues completedValues;
+		m_gpuResources->collectGarbage(getCompletedValues(completedValues));
+	}
+
+	return timelineValue;
+}
+
+const Device::QueueTimeline& Device::getTimeline(VkQueue queue) const {
+	auto it = std::find_if(
+		m_queueTimelines.begin(), m_queueTimelines.end(),
+		[queue](const QueueTimeline& timeline) { return timeline.queue == queue; });
+
+	THROW_ERROR(it == m_queueTimelines.end(), "Invalid queue");
+
+	return *it;
+}
+
+// a command recorded before a destruction can still be submitted after it, so
+// the next submission of a queue with such commands has to complete as well
+std::vector<uint64_t> Device::getRetireValues() const {
+	std::vector<uint64_t> values;
+	values.reserve(m_queueTimelines.size());
+
+	for (const auto& timeline : m_queueTimelines) {
+		values.push_back(timeline.submittedValue +
+						 (timeline.pendingCommands > 0 ? 1 : 0));
 	}
 
-	for (const auto& data : submissionsData) {
-		submitInfos.push_back(data.submitInfo);
+	return values;
+}
+
+std::span<const uint64_t> Device::getCompletedValues(QueueValues& values) const {
+	for (size_t i = 0; i < m_queueTimelines.size(); i++) {
+		values[i] = m_queueTimelines[i].semaphore->getValue();
 	}
 
-	vkQueueSubmit2(queue, static_cast<uint32_t>(submitInfos.size()),
-				   submitInfos.data(), fence ? fence->getHandle() : nullptr);
+	return {values.data(), m_queueTimelines.size()};
+}
+
+void Device::setCommandPending(VkQueue queue, bool pending) const {
+	const QueueTimeline& timeline = getTimeline(queue);
+
+	if (pending) {
+		timeline.pendingCommands++;
+	} else {
+		timeline.pendingCommands--;
+	}
+}
+
+const TimelineSemaphore& Device::getQueueTimeline(VkQueue queue) const {
+	return *getTimeline(queue).semaphore;
+}
+
+std::mutex& Device::getQueueMutex(VkQueue queue) const {
+	return getTimeline(queue).submitMutex;
+}
+
+uint64_t Device::getSubmittedValue(VkQueue queue) const {
+	return getTimeline(queue).submittedValue;
+}
+
+uint64_t Device::getCompletedValue(VkQueue queue) const {
+	return getTimeline(queue).semaphore->getValue();
+}
+
+void Device::waitForValue(VkQueue queue, uint64_t value) const {
+	getTimeline(queue).semaphore->wait(value);
 }
 
 VkSampleCountFlagBits Device::getMaxSampleCount() const {
@@ -375,13 +855,42 @@ bool Device::isFeatureEnabled(const char* feature) const {
 }
 
 void Device::waitIdle() const {
+	std::vector<std::unique_lock<std::mutex>> locks;
+	locks.reserve(m_queueTimelines.size());
+
+	for (const auto& timeline : m_queueTimelines) {
+		locks.emplace_back(timeline.submitMutex);
+	}
+
 	vkDeviceWaitIdle(m_device);
+
+	locks.clear();
+
+	if (m_gpuResources->hasPendingDestructions()) {
+		QueueValues completedValues;
+		m_gpuResources->collectGarbage(getCompletedValues(completedValues));
+	}
 }
 
 Buffer Device::createStagingBuffer(VkDeviceSize size, const void* data) const {
 	return Buffer::allocateStagingBuffer(m_allocator, size, data);
 }
 
+StagingAllocation Device::allocateStaging(VkDeviceSize size,
+										  VkDeviceSize alignment) const {
+	if (m_stagingRing == nullptr || size > m_stagingRing->getSize()) {
+		return {};
+	}
+
+	return m_stagingRing->allocate(size, alignment);
+}
+
+void Device::releaseStaging(const StagingAllocation& allocation) const {
+	assert(m_stagingRing != nullptr && "Staging ring is disabled");
+
+	m_stagingRing->release(allocation);
+}
+
 Buffer Device::createIndexBuffer32(uint32_t elementCount,
 								   const uint32_t* data) const {
 	return Buffer::allocateIndexBuffer32(m_allocator, elementCount, data);
@@ -396,16 +905,14 @@ Image Device::createDepthAttachmentImage(const DepthImageCreateInfo& info) const
 }
 
 Shader Device::createShader(const std::string& shaderPath,
-							VkShaderStageFlagBits stage,
-							size_t pushConstantsSize) const {
-	return Shader::fromFile(m_device, shaderPath, stage, pushConstantsSize);
+							VkShaderStageFlagBits stage) const {
+	return Shader::fromFile(m_device, shaderPath, stage);
 }
 
 Shader Device::createShader(const void* shaderCode,
 							VkDeviceSize codeSize,
-							VkShaderStageFlagBits stage,
-							size_t pushConstantsSize) const {
-	return Shader(m_device, shaderCode, codeSize, stage, pushConstantsSize);
+							VkShaderStageFlagBits stage) const {
+	return Shader(m_device, shaderCode, codeSize, stage);
 }
 
 Fence Device::createFence(bool signaled) const {
@@ -416,6 +923,10 @@ Semaphore Device::createSemaphore() const {
 	return Semaphore(m_device);
 }
 
+TimelineSemaphore Device::createTimelineSemaphore(uint64_t initialValue) const {
+	return TimelineSemaphore(m_device, initialValue);
+}
+
 Swapchain Device::createSwapchain(const SwapchainCreateInfo& info) const {
 	return Swapchain(m_device, m_phyiscalDevice, info);
 }
@@ -442,18 +953,83 @@ ImageId Device::createStorageImage(const ImageCreateInfo& info) const {
 	ImageCreateInfo actualInfo = info;
 	actualInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
 
+	const bool isSampled = (actualInfo.usage & VK_IMAGE_USAGE_SAMPLED_BIT) != 0;
+
 	Image image(m_device, m_allocator, actualInfo);
 
-	return m_gpuResources->registerImage(std::move(image));
+	return m_gpuResources->registerImage(std::move(image),
+										 isSampled ? getSampler({}) : nullptr);
 }
 
 ImageId Device::createSampledImage(const ImageCreateInfo& info) const {
+	return createSampledImage(info, {});
+}
+
+ImageId Device::createSampledImage(const ImageCreateInfo& info,
+								   const Sampler::SamplerInfo& samplerInfo) const {
 	ImageCreateInfo actualInfo = info;
 	actualInfo.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
 
 	Image image(m_device, m_allocator, actualInfo);
 
-	return m_gpuResources->registerImage(std::move(image));
+	return m_gpuResources->registerImage(std::move(image), getSampler(samplerInfo));
+}
+
+VkSampler Device::getSampler(const Sampler::SamplerInfo& info) const {
+	Sampler::SamplerInfo key = info;
+	key.device = this;
+
+	std::lock_guard lock(m_samplersMutex);
+
+	auto it = m_samplers.find(key);
+
+	if (it == m_samplers.end()) {
+		it = m_samplers.emplace(key, std::make_unique<Sampler>(key)).first;
+	}
+
+	return it->second->getHandle();
+}
+
+std::shared_ptr<Pipeline> Device::getOrCreatePipeline(
+	const PipelineCreateInfo& info) const {
+	assert(info.device == this && "The pipeline belongs to another device");
+
+	{
+		std::lock_guard lock(m_pipelinesMutex);
+
+		auto it = m_pipelines.find(info);
+
+		if (it != m_pipelines.end()) {
+			if (auto pipeline = it->second.lock()) {
+				return pipeline;
+			}
+		}
+	}
+
+	// compiled without the lock, so other threads can look up or compile
+	// different pipelines meanwhile
+	auto pipeline = std::make_shared<Pipeline>(info);
+
+	std::lock_guard lock(m_pipelinesMutex);
+
+	auto& entry = m_pipelines[info];
+
+	// another thread compiled the same pipeline first
+	if (auto existing = entry.lock()) {
+		return existing;
+	}
+
+	entry = pipeline;
+
+	// drops the entries of released pipelines once the map has grown enough
+	if (m_pipelines.size() >= m_pipelinesPruneSize) {
+		std::erase_if(m_pipelines,
+					  [](const auto& item) { return item.second.expired(); });
+
+		m_pipelinesPruneSize = std::max<size_t>(64, m_pipelines.size() * 2);
+	}
+
+	return pipeline;
 }
 
 Buffer& Device::getBuffer(BufferId handle) const {
@@ -465,11 +1041,20 @@ Image& Device::getImage(ImageId handle) const {
 }
 
 void Device::destroyBuffer(BufferId handle) {
-	m_gpuResources->destroyBuffer(handle);
+	m_gpuResources->destroyBuffer(handle, getRetireValues());
+	collectGarbage();
 }
 
 void Device::destroyImage(ImageId handle) {
-	m_gpuResources->destroyImage(handle);
+	m_gpuResources->destroyImage(handle, getRetireValues());
+	collectGarbage();
+}
+
+void Device::collectGarbage() {
+	if (m_gpuResources->hasPendingDestructions()) {
+		QueueValues completedValues;
+		m_gpuResources->collectGarbage(getCompletedValues(completedValues));
+	}
 }
 
 void Device::updateBuffer(BufferId handle,
@@ -477,6 +1062,10 @@ void Device::updateBuffer(BufferId handle,
 						  VkDeviceSize offset,
 						  VkDeviceSize size) const {
 	Buffer& buffer = m_gpuResources->getBuffer(handle);
+
+	THROW_ERROR(!buffer.isHostVisible(),
+				"Buffer is not host visible, use Command::updateBuffer");
+
 	buffer.writeData(data, offset, size);
 }
 
@@ -487,3 +1076,11 @@ VkPipelineLayout Device::getPipelineLayout(VkDeviceSize pushConstantSize) const
 VkDescriptorSet Device::getDescriptorSet() const {
 	return m_gpuResources->getDescriptorSet();
 }
+
+VkPipelineCache Device::getPipelineCache() const {
+	return m_pipelineCache->getHandle();
+}
+
+bool Device::savePipelineCache() const {
+	return m_pipelineCache->save();
+}
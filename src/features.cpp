@@ -25,9 +25,19 @@ FeaturesChain::FeaturesChain() {
 		.pNext = &syncrhonization2,
 	};
 
+	timelineSemaphore = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+		.pNext = &descriptorIndexing,
+	};
+
+	hostQueryReset = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES,
+		.pNext = &timelineSemaphore,
+	};
+
 	physicalDeviceFeatures = {
 		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
-		.pNext = &descriptorIndexing,
+		.pNext = &hostQueryReset,
 	};
 }
 
@@ -51,6 +61,14 @@ Device::Features::Features(std::vector<const char*> requiredFeatures,
 			chain.syncrhonization2.synchronization2 = VK_TRUE;
 		}
 
+		if (strcmp(feature, "TimelineSemaphore") == 0) {
+			chain.timelineSemaphore.timelineSemaphore = VK_TRUE;
+		}
+
+		if (strcmp(feature, "HostQueryReset") == 0) {
+			chain.hostQueryReset.hostQueryReset = VK_TRUE;
+		}
+
 		auto& descriptorIndexing = chain.descriptorIndexing;
 
 		if (strcmp(feature, "DescriptorBindingUniformBufferUpdateAfterBind") == 0) {
@@ -68,6 +86,11 @@ Device::Features::Features(std::vector<const char*> requiredFeatures,
 				VK_TRUE;
 		}
 
+		if (strcmp(feature, "DescriptorBindingStorageImageUpdateAfterBind") == 0) {
+			descriptorIndexing.descriptorBindingStorageImageUpdateAfterBind =
+				VK_TRUE;
+		}
+
 		if (strcmp(feature, "DescriptorBindingPartiallyBound") == 0) {
 			descriptorIndexing.descriptorBindingPartiallyBound = VK_TRUE;
 		}
@@ -124,6 +147,14 @@ bool Device::Features::isFeatureEnabled(const char* feature,
 		return chain.syncrhonization2.synchronization2 == VK_TRUE;
 	}
 
+	if (strcmp(feature, "TimelineSemaphore") == 0) {
+		return chain.timelineSemaphore.timelineSemaphore == VK_TRUE;
+	}
+
+	if (strcmp(feature, "HostQueryReset") == 0) {
+		return chain.hostQueryReset.hostQueryReset == VK_TRUE;
+	}
+
 	if (strcmp(feature, "DescriptorBindingUniformBufferUpdateAfterBind") == 0) {
 		return chain.descriptorIndexing
 				   .descriptorBindingUniformBufferUpdateAfterBind == VK_TRUE;
@@ -139,6 +170,11 @@ bool Device::Features::isFeatureEnabled(const char* feature,
 				   .descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE;
 	}
 
+	if (strcmp(feature, "DescriptorBindingStorageImageUpdateAfterBind") == 0) {
+		return chain.descriptorIndexing
+				   .descriptorBindingStorageImageUpdateAfterBind == VK_TRUE;
+	}
+
 	if (strcmp(feature, "DescriptorBindingPartiallyBound") == 0) {
 		return chain.descriptorIndexing.descriptorBindingPartiallyBound == VK_TRUE;
 	}
@@ -11,6 +11,8 @@ struct FeaturesChain {
 	VkPhysicalDeviceDynamicRenderingFeatures dynamicRendering{};
 	VkPhysicalDeviceSynchronization2FeaturesKHR syncrhonization2{};
 	VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexing{};
+	VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphore{};
+	VkPhysicalDeviceHostQueryResetFeatures hostQueryReset{};
 
 	VkPhysicalDeviceFeatures2 physicalDeviceFeatures{};
 };
@@ -1,5 +1,6 @@
 #include "ignis/fence.hpp"
 #include "exceptions.hpp"
+#include "trace.hpp"
 
 using namespace ignis;
 
@@ -21,6 +22,8 @@ Fence::~Fence() {
 }
 
 void Fence::wait() const {
+	IGNIS_TRACE_SCOPE("Fence::wait");
+
 	THROW_VULKAN_ERROR(vkWaitForFences(m_device, 1, &m_fence, VK_TRUE, UINT64_MAX),
 					   "Failed to wait for fence");
 }
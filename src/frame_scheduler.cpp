@@ -0,0 +1,154 @@
+#include <cassert>
+#include "ignis/frame_scheduler.hpp"
+#include "ignis/command.hpp"
+#include "ignis/command_pool.hpp"
+#include "ignis/device.hpp"
+#include "ignis/semaphore.hpp"
+#include "ignis/swapchain.hpp"
+#include "trace.hpp"
+
+using namespace ignis;
+
+FrameScheduler::FrameScheduler(const FrameSchedulerCreateInfo& info)
+	: m_device(info.device),
+	  m_swapchain(info.swapchain),
+	  m_queue(info.queue != nullptr ? info.queue : m_device.getQueue(0)) {
+	assert(info.framesInFlight > 0 && "Invalid number of frames in flight");
+
+	m_frames.resize(info.framesInFlight);
+
+	for (auto& frame : m_frames) {
+		frame.commandPool = std::make_unique<CommandPool>(CommandPoolCreateInfo{
+			.device = m_device,
+			.queue = m_queue,
+		});
+
+		if (m_swapchain != nullptr) {
+			frame.imageAvailable =
+				std::make_unique<Semaphore>(m_device.getDevice());
+		}
+	}
+
+	if (m_swapchain != nullptr) {
+		m_renderFinished.resize(m_swapchain->getImagesCount());
+
+		for (auto& semaphore : m_renderFinished) {
+			semaphore = std::make_unique<Semaphore>(m_device.getDevice());
+		}
+	}
+}
+
+FrameScheduler::~FrameScheduler() {
+	waitIdle();
+}
+
+Command& FrameScheduler::beginFrame() {
+	IGNIS_TRACE_SCOPE("FrameScheduler::beginFrame");
+
+	assert(!m_inFrame && "The previous frame has not ended");
+
+	Frame& frame = m_frames[m_currentFrame];
+
+	// the frame submitted framesInFlight frames ago, the gpu may still be
+	// working on the more recent ones
+	m_device.waitForValue(m_queue, frame.value);
+
+	flushDeletionQueue(frame);
+	m_device.collectGarbage();
+
+	frame.commandPool->reset();
+	frame.command = &frame.commandPool->acquire();
+
+	if (m_swapchain != nullptr) {
+		m_swapchainImage =
+			&m_swapchain->acquireNextImage(frame.imageAvailable.get());
+		m_swapchainImageIndex = m_swapchain->getCurrentImageIndex();
+	}
+
+	frame.command->begin();
+
+	m_inFrame = true;
+
+	return *frame.command;
+}
+
+void FrameScheduler::endFrame() {
+	IGNIS_TRACE_SCOPE("FrameScheduler::endFrame");
+
+	assert(m_inFrame && "The frame has not begun");
+
+	Frame& frame = m_frames[m_currentFrame];
+
+	frame.command->end();
+
+	const Command* commands[]{frame.command};
+
+	SubmitInfo submitInfo{.commands = commands};
+
+	if (m_swapchain != nullptr) {
+		const Semaphore& renderFinished = *m_renderFinished[m_swapchainImageIndex];
+
+		SemaphoreSubmit const waitInfo = frame.imageAvailable->getSubmitInfo(
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+		SemaphoreSubmit const signalInfo = renderFinished.getSubmitInfo();
+
+		submitInfo.waitSemaphores = {&waitInfo, 1};
+		submitInfo.signalSemaphores = {&signalInfo, 1};
+
+		frame.value = m_device.submitCommands({&submitInfo, 1});
+
+		std::lock_guard lock(m_device.getQueueMutex(m_queue));
+
+		m_swapchain->presentCurrent({
+			.presentationQueue = m_queue,
+			.waitSemaphores = {&renderFinished},
+		});
+	} else {
+		frame.value = m_device.submitCommands({&submitInfo, 1});
+	}
+
+	m_currentFrame = (m_currentFrame + 1) % static_cast<uint32_t>(m_frames.size());
+	m_frameNumber++;
+	m_swapchainImage = nullptr;
+	m_inFrame = false;
+}
+
+void FrameScheduler::deferDeletion(std::function<void()> callback) {
+	const auto framesCount = static_cast<uint32_t>(m_frames.size());
+
+	// between frames the last submitted one may still use the resource
+	const uint32_t frameIndex = m_inFrame ? m_currentFrame
+										  : (m_currentFrame + framesCount - 1) %
+												framesCount;
+
+	m_frames[frameIndex].deletionQueue.push_back(std::move(callback));
+}
+
+Command& FrameScheduler::getCommand() const {
+	assert(m_inFrame && "The frame has not begun");
+
+	return *m_frames[m_currentFrame].command;
+}
+
+CommandPool& FrameScheduler::getCommandPool() const {
+	return *m_frames[m_currentFrame].commandPool;
+}
+
+void FrameScheduler::waitIdle() {
+	for (auto& frame : m_frames) {
+		m_device.waitForValue(m_queue, frame.value);
+		flushDeletionQueue(frame);
+	}
+
+	m_device.collectGarbage();
+}
+
+void FrameScheduler::flushDeletionQueue(Frame& frame) {
+	// in reverse, like destructors
+	for (auto it = frame.deletionQueue.rbegin(); it != frame.deletionQueue.rend();
+		 it++) {
+		(*it)();
+	}
+
+	frame.deletionQueue.clear();
+}
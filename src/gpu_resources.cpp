@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include "gpu_resources.hpp"
 #include "exceptions.hpp"
@@ -8,11 +9,16 @@
 using namespace ignis;
 
 Device::GpuResources::GpuResources(const BindlessResourcesCreateInfo& info)
-	: m_creationInfo(info), m_device(info.device) {
+	: m_creationInfo(info),
+	  m_device(info.device),
+	  m_storageBuffers(info.maxStorageBuffers),
+	  m_uniformBuffers(info.maxUniformBuffers, true),
+	  m_images(std::max(info.maxImageSamplers, info.maxStorageImages)) {
 	assert(m_device && "Invalid device");
 	assert(info.maxStorageBuffers && "Invalid max storage buffers");
 	assert(info.maxUniformBuffers && "Invalid max uniform buffers");
 	assert(info.maxImageSamplers && "Invalid max image samplers");
+	assert(info.maxStorageImages && "Invalid max storage images");
 
 	VkDescriptorSetLayoutBinding const uboBindings = {
 		.binding = info.uniformBuffersBinding,
@@ -38,10 +44,19 @@ Device::GpuResources::GpuResources(const BindlessResourcesCreateInfo& info)
 		.pImmutableSamplers = nullptr,
 	};
 
+	VkDescriptorSetLayoutBinding const storageImageBindings = {
+		.binding = info.storageImagesBinding,
+		.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+		.descriptorCount = info.maxStorageImages,
+		.stageFlags = VK_SHADER_STAGE_ALL,
+		.pImmutableSamplers = nullptr,
+	};
+
 	auto bindings = std::vector<VkDescriptorSetLayoutBinding>{
 		uboBindings,
 		ssboBindings,
 		imageSamplerBindings,
+		storageImageBindings,
 	};
 
 	auto bindingFlags = std::vector{
@@ -60,7 +75,7 @@ Device::GpuResources::GpuResources(const BindlessResourcesCreateInfo& info)
 	VkDescriptorSetLayoutBindingFlagsCreateInfo const bindingFlagsCreateInfo{
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
 		.pNext = nullptr,
-		.bindingCount = 3,
+		.bindingCount = static_cast<uint32_t>(bindings.size()),
 		.pBindingFlags = bindingFlags.data(),
 	};
 
@@ -68,7 +83,7 @@ Device::GpuResources::GpuResources(const BindlessResourcesCreateInfo& info)
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
 		.pNext = &bindingFlagsCreateInfo,
 		.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
-		.bindingCount = 3,
+		.bindingCount = static_cast<uint32_t>(bindings.size()),
 		.pBindings = bindings.data(),
 	};
 
@@ -92,10 +107,16 @@ Device::GpuResources::GpuResources(const BindlessResourcesCreateInfo& info)
 		.descriptorCount = info.maxStorageBuffers,
 	};
 
+	VkDescriptorPoolSize const storageImagePoolSize{
+		.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+		.descriptorCount = info.maxStorageImages,
+	};
+
 	auto poolSizes = std::vector<VkDescriptorPoolSize>{
 		texturePoolSize,
 		uboPoolSize,
 		ssboPoolSize,
+		storageImagePoolSize,
 	};
 
 	VkDescriptorPoolCreateInfo const vk_descriptor_pool_create_info{
@@ -104,7 +125,7 @@ Device::GpuResources::GpuResources(const BindlessResourcesCreateInfo& info)
 		.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT |
 				 VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
 		.maxSets = 1,
-		.poolSizeCount = 3,
+		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
 		.pPoolSizes = poolSizes.data(),
 	};
 
@@ -142,7 +163,7 @@ Device::GpuResources::GpuResources(const BindlessResourcesCreateInfo& info)
 					   "Failed to create pipeline layout");
 
 	// create other pipeline layouts
-	for (uint32_t i{1}; i < MAX_PUSH_CONSTANT_WORD_SIZE; i++) {
+	for (uint32_t i{1}; i <= MAX_PUSH_CONSTANT_WORD_SIZE; i++) {
 		VkPushConstantRange const pushConstantRange{
 			.stageFlags = VK_SHADER_STAGE_ALL,
 			.offset = 0,
@@ -167,8 +188,9 @@ Device::GpuResources::~GpuResources() {
 	}
 }
 
-// TODO: recycle buffer ids
 BufferId Device::GpuResources::registerBuffer(Buffer buffer) {
+	std::lock_guard lock(m_mutex);
+
 	const bool isStorageBuffer =
 		(buffer.getUsage() & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) != 0;
 	const bool isUniformBuffer =
@@ -176,90 +198,218 @@ BufferId Device::GpuResources::registerBuffer(Buffer buffer) {
 
 	assert((isStorageBuffer || isUniformBuffer) && "Invalid buffer usage");
 
-	BufferId id = nextBufferId++;
+	const VkBuffer handle = buffer.getHandle();
+	const VkDeviceSize size = buffer.getSize();
+
+	BufferId id = isStorageBuffer ? m_storageBuffers.insert(std::move(buffer))
+								  : m_uniformBuffers.insert(std::move(buffer));
+
+	THROW_ERROR(id == IGNIS_INVALID_BUFFER_ID, isStorageBuffer
+												   ? "Too many storage buffers"
+												   : "Too many uniform buffers");
 
-	VkDescriptorBufferInfo const bufferInfo{
-		.buffer = buffer.getHandle(),
+	const uint32_t index = getResourceIndex(id);
+
+	// the deque keeps the info address stable until the next flush
+	m_pendingBufferInfos.push_back({
+		.buffer = handle,
 		.offset = 0,
-		.range = buffer.getSize(),
-	};
+		.range = size,
+	});
 
-	VkWriteDescriptorSet const writeDescriptorSet{
+	m_pendingWrites.push_back({
 		.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
 		.dstSet = m_descriptorSet,
 		.dstBinding = isStorageBuffer ? m_creationInfo.storageBuffersBinding
 									  : m_creationInfo.uniformBuffersBinding,
-		.dstArrayElement = id,
+		.dstArrayElement = index,
 		.descriptorCount = 1,
 		.descriptorType = isStorageBuffer ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
 										  : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-		.pBufferInfo = &bufferInfo,
-	};
-
-	vkUpdateDescriptorSets(m_device, 1, &writeDescriptorSet, 0, nullptr);
-
-	m_buffers.insert({id, std::make_unique<Buffer>(std::move(buffer))});
+		.pBufferInfo = &m_pendingBufferInfos.back(),
+	});
 
 	return id;
 };
 
-// TODO: recycle image ids
-BufferId Device::GpuResources::registerImage(Image image) {
+ImageId Device::GpuResources::registerImage(Image image, VkSampler sampler) {
+	std::lock_guard lock(m_mutex);
+
 	const bool isStorageImage = (image.getUsage() & VK_IMAGE_USAGE_STORAGE_BIT) != 0;
 	const bool isSampledImage = (image.getUsage() & VK_IMAGE_USAGE_SAMPLED_BIT) != 0;
 
 	assert((isStorageImage || isSampledImage) && "Invalid image usage");
+	assert((!isSampledImage || sampler) && "Invalid sampler");
+
+	const VkImageView view = image.getViewHandle();
+
+	// an image can be both sampled and storage and then takes the same index
+	// in both arrays, so images share one index space limited per usage
+	const uint32_t samplerLimit =
+		isSampledImage ? m_creationInfo.maxImageSamplers : UINT32_MAX;
+	const uint32_t storageLimit =
+		isStorageImage ? m_creationInfo.maxStorageImages : UINT32_MAX;
+
+	ImageId id =
+		m_images.insert(std::move(image), std::min(samplerLimit, storageLimit));
+
+	THROW_ERROR(id == IGNIS_INVALID_IMAGE_ID, samplerLimit <= storageLimit
+												  ? "Too many sampled images"
+												  : "Too many storage images");
+
+	const uint32_t index = getResourceIndex(id);
+
+	if (isSampledImage) {
+		m_pendingImageInfos.push_back({
+			.sampler = sampler,
+			.imageView = view,
+			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		});
+
+		m_pendingWrites.push_back({
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = m_descriptorSet,
+			.dstBinding = m_creationInfo.imageSamplersBinding,
+			.dstArrayElement = index,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			.pImageInfo = &m_pendingImageInfos.back(),
+		});
+	}
 
-	ImageId id = nextImageId++;
-
-	// TODO: implement
+	if (isStorageImage) {
+		m_pendingImageInfos.push_back({
+			.sampler = nullptr,
+			.imageView = view,
+			.imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+		});
+
+		m_pendingWrites.push_back({
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = m_descriptorSet,
+			.dstBinding = m_creationInfo.storageImagesBinding,
+			.dstArrayElement = index,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+			.pImageInfo = &m_pendingImageInfos.back(),
+		});
+	}
 
 	return id;
 }
 
+void Device::GpuResources::flushDescriptorWrites() {
+	std::lock_guard lock(m_mutex);
+
+	flushPendingWrites();
+}
+
+void Device::GpuResources::flushPendingWrites() {
+	if (m_pendingWrites.empty()) {
+		return;
+	}
+
+	vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(m_pendingWrites.size()),
+						   m_pendingWrites.data(), 0, nullptr);
+
+	m_pendingWrites.clear();
+	m_pendingBufferInfos.clear();
+	m_pendingImageInfos.clear();
+}
+
 VkPipelineLayout Device::GpuResources::getPipelinelayout(
 	VkDeviceSize pushConstantSize) const {
 	THROW_ERROR(
 		static_cast<uint32_t>(pushConstantSize) > 4 * MAX_PUSH_CONSTANT_WORD_SIZE,
 		"Invalid push constant size");
 
-	return m_pipelineLayouts.at(1 + (pushConstantSize / 4));
+	// the tightest layout holding the push constants, one per word count
+	return m_pipelineLayouts[(pushConstantSize + 3) / 4];
 }
 
 Buffer& Device::GpuResources::getBuffer(BufferId id) const {
-	auto it = m_buffers.find(id);
+	std::lock_guard lock(m_mutex);
+
+	Buffer* buffer = getBufferMap(id).get(id);
 
-	THROW_ERROR(it == m_buffers.end(), "Invalid buffer handle");
+	THROW_ERROR(buffer == nullptr, "Invalid buffer handle");
 
-	return *it->second;
+	return *buffer;
 }
 
 Image& Device::GpuResources::getImage(ImageId id) const {
-	auto it = m_images.find(id);
+	std::lock_guard lock(m_mutex);
 
-	THROW_ERROR(it == m_images.end(), "Invalid image handle");
+	Image* image = m_images.get(id);
 
-	return *it->second;
-}
+	THROW_ERROR(image == nullptr, "Invalid image handle");
 
-void Device::GpuResources::destroyBuffer(BufferId& id) {
-	id = IGNIS_INVALID_BUFFER_ID;
+	return *image;
+}
 
-	auto it = m_buffers.find(id);
+void Device::GpuResources::destroyBuffer(BufferId& id,
+										 std::vector<uint64_t> retireValues) {
+	std::lock_guard lock(m_mutex);
 
-	if (it == m_buffers.end()) {
-		return;
+	if (getBufferMap(id).get(id) != nullptr) {
+		m_deletionQueue.push_back({
+			.id = id,
+			.isImage = false,
+			.retireValues = std::move(retireValues),
+		});
 	}
 
-	m_buffers.erase(it);
+	id = IGNIS_INVALID_BUFFER_ID;
 }
 
-void Device::GpuResources::destroyImage(ImageId& id) {
-	auto it = m_images.find(id);
+void Device::GpuResources::destroyImage(ImageId& id,
+										std::vector<uint64_t> retireValues) {
+	std::lock_guard lock(m_mutex);
 
-	THROW_ERROR(it == m_images.end(), "Invalid image handle");
+	THROW_ERROR(m_images.get(id) == nullptr, "Invalid image handle");
 
-	m_images.erase(it);
+	m_deletionQueue.push_back({
+		.id = id,
+		.isImage = true,
+		.retireValues = std::move(retireValues),
+	});
 
 	id = IGNIS_INVALID_IMAGE_ID;
 }
+
+void Device::GpuResources::collectGarbage(
+	std::span<const uint64_t> completedValues) {
+	std::lock_guard lock(m_mutex);
+
+	// pending writes may still reference the resources about to be destroyed
+	if (!m_deletionQueue.empty()) {
+		flushPendingWrites();
+	}
+
+	// submitted values only grow, so entries retire in order
+	while (!m_deletionQueue.empty()) {
+		const auto& pending = m_deletionQueue.front();
+
+		assert(pending.retireValues.size() == completedValues.size());
+
+		for (size_t i = 0; i < completedValues.size(); i++) {
+			if (completedValues[i] < pending.retireValues[i]) {
+				return;
+			}
+		}
+
+		if (pending.isImage) {
+			m_images.erase(pending.id);
+		} else {
+			getBufferMap(pending.id).erase(pending.id);
+		}
+
+		m_deletionQueue.pop_front();
+	}
+}
+
+bool Device::GpuResources::hasPendingDestructions() const {
+	std::lock_guard lock(m_mutex);
+
+	return !m_deletionQueue.empty();
+}
@@ -1,4 +1,11 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
 #include "ignis/device.hpp"
+#include "ignis/buffer.hpp"
+#include "ignis/image.hpp"
+#include "slot_map.hpp"
 
 namespace ignis {
 
@@ -12,14 +19,13 @@ struct BindlessResourcesCreateInfo {
 	uint32_t maxStorageBuffers{0};
 	uint32_t maxUniformBuffers{0};
 	uint32_t maxImageSamplers{0};
+	uint32_t maxStorageImages{0};
 	uint32_t storageBuffersBinding{0};
 	uint32_t uniformBuffersBinding{1};
 	uint32_t imageSamplersBinding{2};
+	uint32_t storageImagesBinding{3};
 };
 
-class Buffer;
-class Image;
-
 class Device::GpuResources {
 public:
 	GpuResources(const BindlessResourcesCreateInfo&);
@@ -32,15 +38,36 @@ public:
 
 	BufferId registerBuffer(Buffer buffer);
 
-	ImageId registerImage(Image image);
+	// the sampler is only used by sampled images
+	ImageId registerImage(Image image, VkSampler sampler);
+
+	// descriptor writes are queued and issued in a single vkUpdateDescriptorSets
+	void flushDescriptorWrites();
 
 	Buffer& getBuffer(BufferId) const;
 
 	Image& getImage(ImageId) const;
 
-	void destroyBuffer(BufferId&);
+	// the resource and its descriptor slot are released once every queue
+	// timeline has reached the given values (one per queue)
+	void destroyBuffer(BufferId&, std::vector<uint64_t> retireValues);
+
+	void destroyImage(ImageId&, std::vector<uint64_t> retireValues);
 
-	void destroyImage(ImageId&);
+	void collectGarbage(std::span<const uint64_t> completedValues);
+
+	bool hasPendingDestructions() const;
+
+private:
+	void flushPendingWrites();
+
+	SlotMap<Buffer>& getBufferMap(BufferId id) {
+		return (id & IGNIS_RESOURCE_TAG_BIT) ? m_uniformBuffers : m_storageBuffers;
+	}
+
+	const SlotMap<Buffer>& getBufferMap(BufferId id) const {
+		return (id & IGNIS_RESOURCE_TAG_BIT) ? m_uniformBuffers : m_storageBuffers;
+	}
 
 private:
 	VkDevice m_device;
@@ -51,10 +78,26 @@ private:
 	VkDescriptorSet m_descriptorSet{nullptr};
 	std::array<VkPipelineLayout, PIPELINE_LAYOUT_COUNT> m_pipelineLayouts{};
 
-	std::unordered_map<BufferId, std::unique_ptr<Buffer>> m_buffers;
-	std::unordered_map<ImageId, std::unique_ptr<Image>> m_images;
-	BufferId nextBufferId{0};
-	ImageId nextImageId{0};
+	std::vector<VkWriteDescriptorSet> m_pendingWrites;
+	std::deque<VkDescriptorBufferInfo> m_pendingBufferInfos;
+	std::deque<VkDescriptorImageInfo> m_pendingImageInfos;
+
+	// separate index spaces, so storage buffers can't use up the low indices
+	// a smaller uniform buffer array needs
+	SlotMap<Buffer> m_storageBuffers;
+	SlotMap<Buffer> m_uniformBuffers;
+	SlotMap<Image> m_images;
+
+	struct PendingDestruction {
+		uint32_t id;
+		bool isImage;
+		std::vector<uint64_t> retireValues;
+	};
+
+	std::deque<PendingDestruction> m_deletionQueue;
+
+	// registrations, destructions and flushes come from every submitting thread
+	mutable std::mutex m_mutex;
 
 public:
 	GpuResources(const GpuResources&) = delete;
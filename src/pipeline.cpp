@@ -2,10 +2,14 @@
 #include "ignis/pipeline.hpp"
 #include "ignis/device.hpp"
 #include "exceptions.hpp"
+#include "trace.hpp"
+#include "vk_utils.hpp"
 
 using namespace ignis;
 
 Pipeline::Pipeline(const PipelineCreateInfo& info) : m_device(*info.device) {
+	IGNIS_TRACE_SCOPE("Pipeline::Pipeline");
+
 	assert(!info.shaders.empty() && "No shaders provided");
 
 	m_pipelineLayout =
@@ -19,7 +23,7 @@ Pipeline::Pipeline(const PipelineCreateInfo& info) : m_device(*info.device) {
 			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
 			.stage = shader->getStage(),
 			.module = shader->getModule(),
-			.pName = "main",
+			.pName = shader->getEntryPoint().c_str(),
 		});
 	}
 
@@ -132,11 +136,75 @@ Pipeline::Pipeline(const PipelineCreateInfo& info) : m_device(*info.device) {
 	};
 
 	THROW_VULKAN_ERROR(
-		vkCreateGraphicsPipelines(m_device.getDevice(), VK_NULL_HANDLE, 1,
-								  &pipelineInfo, nullptr, &m_pipeline),
+		vkCreateGraphicsPipelines(m_device.getDevice(), m_device.getPipelineCache(),
+								  1, &pipelineInfo, nullptr, &m_pipeline),
 		"Failed to create pipeline");
 }
 
 Pipeline::~Pipeline() {
 	vkDestroyPipeline(m_device.getDevice(), m_pipeline, nullptr);
 }
+
+ComputePipeline::ComputePipeline(const ComputePipelineCreateInfo& info)
+	: m_device(*info.device) {
+	IGNIS_TRACE_SCOPE("ComputePipeline::ComputePipeline");
+
+	assert(info.shader != nullptr && "No shader provided");
+	assert(info.shader->getStage() == VK_SHADER_STAGE_COMPUTE_BIT &&
+		   "The shader is not a compute shader");
+
+	m_pipelineLayout =
+		m_device.getPipelineLayout(info.shader->getPushConstantSize());
+
+	VkComputePipelineCreateInfo const pipelineInfo{
+		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		.stage =
+			{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+				.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+				.module = info.shader->getModule(),
+				.pName = info.shader->getEntryPoint().c_str(),
+			},
+		.layout = m_pipelineLayout,
+	};
+
+	THROW_VULKAN_ERROR(
+		vkCreateComputePipelines(m_device.getDevice(), m_device.getPipelineCache(),
+								 1, &pipelineInfo, nullptr, &m_pipeline),
+		"Failed to create compute pipeline");
+}
+
+ComputePipeline::~ComputePipeline() {
+	vkDestroyPipeline(m_device.getDevice(), m_pipeline, nullptr);
+}
+
+size_t PipelineCreateInfo::Hash::operator()(const PipelineCreateInfo& info) const {
+	size_t seed = 0;
+
+	for (const auto* shader : info.shaders) {
+		hashCombine(seed, shader);
+	}
+
+	hashCombine(seed, static_cast<int>(info.colorFormat));
+	hashCombine(seed, info.renderColor);
+	hashCombine(seed, static_cast<int>(info.depthFormat));
+	hashCombine(seed, static_cast<int>(info.cullMode));
+	hashCombine(seed, static_cast<int>(info.frontFace));
+	hashCombine(seed, static_cast<int>(info.polygonMode));
+	hashCombine(seed, static_cast<int>(info.depthCompareOp));
+	hashCombine(seed, info.lineWidth);
+	hashCombine(seed, static_cast<int>(info.sampleCount));
+	hashCombine(seed, info.sampleShadingEnable);
+	hashCombine(seed, info.minSampleShading);
+	hashCombine(seed, info.enableDepthTest);
+	hashCombine(seed, info.enableDepthWrite);
+	hashCombine(seed, info.blendEnable);
+	hashCombine(seed, static_cast<int>(info.srcColorBlendFactor));
+	hashCombine(seed, static_cast<int>(info.dstColorBlendFactor));
+	hashCombine(seed, static_cast<int>(info.colorBlendOp));
+	hashCombine(seed, static_cast<int>(info.srcAlphaBlendFactor));
+	hashCombine(seed, static_cast<int>(info.dstAlphaBlendFactor));
+	hashCombine(seed, static_cast<int>(info.alphaBlendOp));
+
+	return seed;
+}
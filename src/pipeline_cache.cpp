@@ -0,0 +1,127 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "pipeline_cache.hpp"
+#include "exceptions.hpp"
+
+using namespace ignis;
+
+static std::vector<char> readFile(const std::string& path) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+	if (!file.is_open()) {
+		return {};
+	}
+
+	std::vector<char> data(static_cast<size_t>(file.tellg()));
+
+	file.seekg(0);
+
+	if (!file.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+		return {};
+	}
+
+	return data;
+}
+
+static bool isCompatible(const std::vector<char>& data,
+						 const VkPhysicalDeviceProperties& properties) {
+	VkPipelineCacheHeaderVersionOne header{};
+
+	if (data.size() < sizeof(header)) {
+		return false;
+	}
+
+	memcpy(&header, data.data(), sizeof(header));
+
+	return header.headerSize >= sizeof(header) && header.headerSize <= data.size() &&
+		   header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		   header.vendorID == properties.vendorID &&
+		   header.deviceID == properties.deviceID &&
+		   memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID,
+				  VK_UUID_SIZE) == 0;
+}
+
+Device::PipelineCache::PipelineCache(const VkDevice device,
+									 const VkPhysicalDeviceProperties& properties,
+									 const std::string& path)
+	: m_device(device), m_path(path) {
+	std::vector<char> data;
+
+	if (!m_path.empty()) {
+		data = readFile(m_path);
+	}
+
+	// a stale or corrupted file is dropped, it is overwritten on save
+	if (!isCompatible(data, properties)) {
+		data.clear();
+	}
+
+	VkPipelineCacheCreateInfo const cacheInfo{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.initialDataSize = data.size(),
+		.pInitialData = data.empty() ? nullptr : data.data(),
+	};
+
+	THROW_VULKAN_ERROR(
+		vkCreatePipelineCache(m_device, &cacheInfo, nullptr, &m_pipelineCache),
+		"Failed to create pipeline cache");
+}
+
+Device::PipelineCache::~PipelineCache() {
+	vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+}
+
+bool Device::PipelineCache::save() {
+	if (m_path.empty()) {
+		return true;
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	size_t size{0};
+
+	if (vkGetPipelineCacheData(m_device, m_pipelineCache, &size, nullptr) !=
+		VK_SUCCESS) {
+		return false;
+	}
+
+	std::vector<char> data(size);
+
+	if (vkGetPipelineCacheData(m_device, m_pipelineCache, &size, data.data()) !=
+		VK_SUCCESS) {
+		return false;
+	}
+
+	// every writer gets its own temporary file, the rename replaces the cache
+	// atomically
+	const std::string tempPath =
+		m_path + ".tmp" + std::to_string(std::random_device{}());
+
+	std::error_code error;
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+		file.write(data.data(), static_cast<std::streamsize>(size));
+
+		// close flushes, a full disk may only show up here
+		file.close();
+
+		if (file.fail()) {
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, m_path, error);
+
+	if (error) {
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <mutex>
+#include "ignis/device.hpp"
+
+namespace ignis {
+
+// A VkPipelineCache backed by a file. The file is ignored when its header
+// doesn't match the physical device, and it is replaced atomically on save,
+// so concurrent writers never leave a torn file behind (the last one wins).
+class Device::PipelineCache {
+public:
+	PipelineCache(VkDevice,
+				  const VkPhysicalDeviceProperties&,
+				  const std::string& path);
+
+	~PipelineCache();
+
+	VkPipelineCache getHandle() const { return m_pipelineCache; }
+
+	// does nothing without a path; returns false if the file can't be written
+	bool save();
+
+private:
+	const VkDevice m_device;
+	VkPipelineCache m_pipelineCache{nullptr};
+	std::string m_path;
+	std::mutex m_mutex;
+
+public:
+	PipelineCache(const PipelineCache&) = delete;
+	PipelineCache(PipelineCache&&) = delete;
+	PipelineCache& operator=(const PipelineCache&) = delete;
+	PipelineCache& operator=(PipelineCache&&) = delete;
+};
+
+}  // namespace ignis
@@ -0,0 +1,127 @@
+#include <cassert>
+#include "ignis/pipeline_compiler.hpp"
+#include "trace.hpp"
+
+using namespace ignis;
+
+bool AsyncPipeline::isReady() const {
+	return m_future.valid() && m_future.wait_for(std::chrono::seconds(0)) ==
+								   std::future_status::ready;
+}
+
+const Pipeline& AsyncPipeline::getOr(const Pipeline& fallback) const {
+	if (!isReady()) {
+		return fallback;
+	}
+
+	try {
+		return *m_future.get();
+	} catch (...) {
+		return fallback;
+	}
+}
+
+PipelineCompiler::PipelineCompiler(const PipelineCompilerCreateInfo& info)
+	: m_device(info.device) {
+	uint32_t threadCount = info.threadCount;
+
+	if (threadCount == 0) {
+		const uint32_t cores = std::thread::hardware_concurrency();
+		threadCount = cores > 1 ? cores - 1 : 1;
+	}
+
+	m_workers.reserve(threadCount);
+
+	for (uint32_t i = 0; i < threadCount; i++) {
+		m_workers.emplace_back(&PipelineCompiler::work, this);
+	}
+}
+
+PipelineCompiler::~PipelineCompiler() {
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+		m_jobs.clear();
+	}
+
+	m_jobAvailable.notify_all();
+
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+}
+
+AsyncPipeline PipelineCompiler::compile(const PipelineCreateInfo& info) {
+	AsyncPipeline pipeline = enqueue(info);
+
+	m_jobAvailable.notify_one();
+
+	return pipeline;
+}
+
+std::vector<AsyncPipeline> PipelineCompiler::compile(
+	std::span<const PipelineCreateInfo> infos) {
+	std::vector<AsyncPipeline> pipelines;
+	pipelines.reserve(infos.size());
+
+	for (const auto& info : infos) {
+		pipelines.push_back(enqueue(info));
+	}
+
+	m_jobAvailable.notify_all();
+
+	return pipelines;
+}
+
+void PipelineCompiler::waitIdle() {
+	std::unique_lock lock(m_mutex);
+
+	m_idle.wait(lock, [this] { return m_jobs.empty() && m_activeJobs == 0; });
+}
+
+AsyncPipeline PipelineCompiler::enqueue(const PipelineCreateInfo& info) {
+	assert((info.device == nullptr || info.device == &m_device) &&
+		   "Pipeline belongs to another device");
+
+	std::lock_guard lock(m_mutex);
+
+	Job& job = m_jobs.emplace_back(Job{.info = info});
+	job.info.device = &m_device;
+
+	return {job.promise.get_future().share()};
+}
+
+void PipelineCompiler::work() {
+	while (true) {
+		Job job;
+
+		{
+			std::unique_lock lock(m_mutex);
+
+			m_jobAvailable.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+
+			if (m_stop) {
+				return;
+			}
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+			m_activeJobs++;
+		}
+
+		IGNIS_TRACE_SCOPE("PipelineCompiler::work");
+
+		try {
+			job.promise.set_value(std::make_shared<Pipeline>(job.info));
+		} catch (...) {
+			job.promise.set_exception(std::current_exception());
+		}
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_activeJobs--;
+		}
+
+		m_idle.notify_all();
+	}
+}
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <cassert>
+#include "ignis/profiler.hpp"
+#include "ignis/command.hpp"
+#include "ignis/device.hpp"
+#include "exceptions.hpp"
+#include "trace.hpp"
+
+using namespace ignis;
+
+GpuProfiler::GpuProfiler(const GpuProfilerCreateInfo& info)
+	: m_parentDevice(info.device),
+	  m_device(info.device.getDevice()),
+	  m_maxQueries(info.maxZonesPerFrame * 2),
+	  m_historySize(info.historySize),
+	  m_frames(info.framesInFlight) {
+	assert(info.framesInFlight && "Invalid frames in flight");
+	assert(info.maxZonesPerFrame && "Invalid max zones per frame");
+
+	const auto properties = info.device.getPhysicalDeviceProperties();
+
+	m_timestampPeriod = properties.limits.timestampPeriod;
+
+	uint32_t familyCount{0};
+	vkGetPhysicalDeviceQueueFamilyProperties(info.device.getPhysicalDevice(),
+											 &familyCount, nullptr);
+
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(info.device.getPhysicalDevice(),
+											 &familyCount, families.data());
+
+	const uint32_t validBits =
+		families.at(info.device.getGraphicsFamilyIndex()).timestampValidBits;
+
+	THROW_ERROR(validBits == 0, "The graphics queue does not support timestamps");
+
+	m_timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t{1} << validBits) - 1;
+
+	VkQueryPoolCreateInfo const poolInfo{
+		.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+		.queryType = VK_QUERY_TYPE_TIMESTAMP,
+		.queryCount = m_maxQueries,
+	};
+
+	for (auto& frame : m_frames) {
+		THROW_VULKAN_ERROR(
+			vkCreateQueryPool(m_device, &poolInfo, nullptr, &frame.queryPool),
+			"Failed to create query pool");
+
+		vkResetQueryPool(m_device, frame.queryPool, 0, m_maxQueries);
+
+		frame.zones.reserve(info.maxZonesPerFrame);
+	}
+
+	// a value and its availability for each query
+	m_queryResults.resize(m_maxQueries * 2);
+
+	// the first beginFrame moves to the first pool
+	m_currentFrame = static_cast<uint32_t>(m_frames.size()) - 1;
+
+	if (trace::isEnabled()) {
+		calibrate(info.device);
+	}
+}
+
+GpuProfiler::~GpuProfiler() {
+	for (auto& frame : m_frames) {
+		vkDestroyQueryPool(m_device, frame.queryPool, nullptr);
+	}
+}
+
+void GpuProfiler::beginFrame() {
+	assert(m_depth == 0 && "Unbalanced profile zones");
+
+	const auto frameCount = static_cast<uint32_t>(m_frames.size());
+
+	m_currentFrame = (m_currentFrame + 1) % frameCount;
+
+	// oldest first, a frame can't finish before the ones submitted earlier
+	for (uint32_t i = 0; i < frameCount; i++) {
+		Frame& frame = m_frames[(m_currentFrame + i) % frameCount];
+
+		if (!frame.pending) {
+			continue;
+		}
+
+		// the pool about to be reused keeps only the zones that are available
+		if (!resolveFrame(frame, i == 0)) {
+			break;
+		}
+
+		frame.pending = false;
+	}
+
+	Frame& frame = m_frames[m_currentFrame];
+
+	if (frame.queryCount > 0) {
+		vkResetQueryPool(m_device, frame.queryPool, 0, frame.queryCount);
+	}
+
+	frame.queryCount = 0;
+	frame.number = ++m_frameNumber;
+	frame.pending = false;
+	frame.zones.clear();
+
+	if (trace::isEnabled()) {
+		trace::addInstant("frame", "ignis", trace::now());
+	}
+}
+
+uint32_t GpuProfiler::beginZone(Command& command, const char* name) {
+	assert(m_parentDevice.getQueueFamilyIndex(command.getQueue()) ==
+			   m_parentDevice.getGraphicsFamilyIndex() &&
+		   "Profile zones need a graphics queue command");
+
+	Frame& frame = m_frames[m_currentFrame];
+
+	if (frame.queryCount + 2 > m_maxQueries) {
+		return UINT32_MAX;
+	}
+
+	const auto zone = static_cast<uint32_t>(frame.zones.size());
+
+	frame.zones.push_back({
+		.name = name,
+		.depth = m_depth++,
+		.beginQuery = frame.queryCount++,
+		.endQuery = frame.queryCount++,
+	});
+
+	frame.pending = true;
+
+	vkCmdWriteTimestamp2(command.getHandle(), VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+						 frame.queryPool, frame.zones.back().beginQuery);
+
+	return zone;
+}
+
+void GpuProfiler::endZone(Command& command, uint32_t zone) {
+	assert(m_parentDevice.getQueueFamilyIndex(command.getQueue()) ==
+			   m_parentDevice.getGraphicsFamilyIndex() &&
+		   "Profile zones need a graphics queue command");
+
+	if (zone == UINT32_MAX) {
+		return;
+	}
+
+	Frame& frame = m_frames[m_currentFrame];
+
+	assert(zone < frame.zones.size() && "Invalid zone");
+	assert(m_depth > 0 && "Unbalanced profile zones");
+
+	m_depth--;
+
+	vkCmdWriteTimestamp2(command.getHandle(), VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT,
+						 frame.queryPool, frame.zones[zone].endQuery);
+}
+
+bool GpuProfiler::resolveFrame(Frame& frame, bool partial) {
+	if (frame.queryCount == 0) {
+		return true;
+	}
+
+	const VkResult result = vkGetQueryPoolResults(
+		m_device, frame.queryPool, 0, frame.queryCount,
+		frame.queryCount * 2 * sizeof(uint64_t), m_queryResults.data(),
+		2 * sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+	if (result == VK_NOT_READY && !partial) {
+		return false;
+	}
+
+	if (result != VK_NOT_READY) {
+		THROW_VULKAN_ERROR(result, "Failed to get query results");
+	}
+
+	auto getTicks = [this](uint32_t query) {
+		return m_queryResults[query * 2] & m_timestampMask;
+	};
+
+	auto isAvailable = [this](uint32_t query) {
+		return m_queryResults[query * 2 + 1] != 0;
+	};
+
+	const double msPerTick = m_timestampPeriod / 1e6;
+
+	uint64_t frameStart = UINT64_MAX;
+	for (const auto& zone : frame.zones) {
+		if (isAvailable(zone.beginQuery)) {
+			frameStart = std::min(frameStart, getTicks(zone.beginQuery));
+		}
+	}
+
+	m_lastResults.clear();
+
+	for (const auto& zone : frame.zones) {
+		// a zone that was never closed or submitted
+		if (!isAvailable(zone.beginQuery) || !isAvailable(zone.endQuery)) {
+			continue;
+		}
+
+		const uint64_t begin = getTicks(zone.beginQuery);
+		const uint64_t end = getTicks(zone.endQuery);
+
+		m_lastResults.push_back({
+			.name = zone.name,
+			.depth = zone.depth,
+			.frame = frame.number,
+			.beginMs = static_cast<double>(begin - frameStart) * msPerTick,
+			.endMs = static_cast<double>(end - frameStart) * msPerTick,
+			.beginTicks = begin,
+			.endTicks = end,
+		});
+
+		auto& history = m_history[zone.name];
+
+		history.push_back(static_cast<double>((end - begin) & m_timestampMask) *
+						  msPerTick);
+
+		if (history.size() > m_historySize) {
+			history.pop_front();
+		}
+
+		if (trace::isEnabled()) {
+			trace::addSpan(zone.name, "gpu", toTraceTime(begin), toTraceTime(end),
+						   trace::GPU_PROCESS);
+		}
+	}
+
+	std::stable_sort(m_lastResults.begin(), m_lastResults.end(),
+					 [](const GpuZoneResult& a, const GpuZoneResult& b) {
+						 return a.beginTicks < b.beginTicks;
+					 });
+
+	return true;
+}
+
+void GpuProfiler::calibrate(const Device& device) {
+	Command command({.device = device, .queue = nullptr});
+
+	command.begin();
+	vkCmdWriteTimestamp2(command.getHandle(), VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT,
+						 m_frames[0].queryPool, 0);
+	command.end();
+
+	const Command* commands[]{&command};
+	SubmitInfo const submitInfo{.commands = commands};
+
+	const uint64_t value = device.submitCommands({&submitInfo, 1});
+	device.waitForValue(command.getQueue(), value);
+
+	// the cpu time lags behind by the wake up latency
+	m_calibrationNs = trace::now();
+
+	uint64_t ticks{0};
+	THROW_VULKAN_ERROR(
+		vkGetQueryPoolResults(m_device, m_frames[0].queryPool, 0, 1, sizeof(ticks),
+							  &ticks, sizeof(ticks),
+							  VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT),
+		"Failed to get calibration timestamp");
+
+	m_calibrationTicks = ticks & m_timestampMask;
+
+	vkResetQueryPool(m_device, m_frames[0].queryPool, 0, 1);
+}
+
+uint64_t GpuProfiler::toTraceTime(uint64_t ticks) const {
+	const auto elapsed = static_cast<int64_t>(ticks - m_calibrationTicks);
+
+	return m_calibrationNs +
+		   static_cast<int64_t>(static_cast<double>(elapsed) * m_timestampPeriod);
+}
+
+const std::deque<double>& GpuProfiler::getZoneHistory(
+	const std::string& name) const {
+	static const std::deque<double> empty;
+
+	auto it = m_history.find(name);
+
+	return it != m_history.end() ? it->second : empty;
+}
+
+double GpuProfiler::getAverageMs(const std::string& name) const {
+	const auto& history = getZoneHistory(name);
+
+	if (history.empty()) {
+		return 0.0;
+	}
+
+	double sum{0.0};
+	for (double ms : history) {
+		sum += ms;
+	}
+
+	return sum / static_cast<double>(history.size());
+}
@@ -0,0 +1,62 @@
+#include <cassert>
+#include "ignis/sampler.hpp"
+#include "ignis/device.hpp"
+#include "exceptions.hpp"
+#include "vk_utils.hpp"
+
+using namespace ignis;
+
+Sampler::Sampler(SamplerInfo info) : m_info(info) {
+	assert(m_info.device && "Invalid device");
+
+	VkSamplerCreateInfo const samplerInfo{
+		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.magFilter = m_info.m_magFilter,
+		.minFilter = m_info.m_minFilter,
+		.mipmapMode = m_info.m_mipmapMode,
+		.addressModeU = m_info.m_addressModeU,
+		.addressModeV = m_info.m_addressModeV,
+		.addressModeW = m_info.m_addressModeW,
+		.mipLodBias = m_info.m_mipLodBias,
+		.anisotropyEnable = m_info.m_anisotropyEnable,
+		.maxAnisotropy = m_info.m_maxAnisotropy,
+		.compareEnable = m_info.m_compareEnable,
+		.compareOp = m_info.m_compareOp,
+		.minLod = m_info.m_minLod,
+		.maxLod = m_info.m_maxLod,
+		.borderColor = m_info.m_borderColor,
+		.unnormalizedCoordinates = m_info.m_unnormalizedCoordinates,
+	};
+
+	THROW_VULKAN_ERROR(vkCreateSampler(m_info.device->getDevice(), &samplerInfo,
+									   nullptr, &m_sampler),
+					   "Failed to create sampler");
+}
+
+Sampler::~Sampler() {
+	vkDestroySampler(m_info.device->getDevice(), m_sampler, nullptr);
+}
+
+size_t Sampler::Hash::operator()(const SamplerInfo& info) const {
+	size_t seed = 0;
+
+	hashCombine(seed, static_cast<int>(info.m_magFilter));
+	hashCombine(seed, static_cast<int>(info.m_minFilter));
+	hashCombine(seed, static_cast<int>(info.m_mipmapMode));
+	hashCombine(seed, static_cast<int>(info.m_addressModeU));
+	hashCombine(seed, static_cast<int>(info.m_addressModeV));
+	hashCombine(seed, static_cast<int>(info.m_addressModeW));
+	hashCombine(seed, info.m_mipLodBias);
+	hashCombine(seed, info.m_anisotropyEnable);
+	hashCombine(seed, info.m_maxAnisotropy);
+	hashCombine(seed, info.m_compareEnable);
+	hashCombine(seed, static_cast<int>(info.m_compareOp));
+	hashCombine(seed, info.m_minLod);
+	hashCombine(seed, info.m_maxLod);
+	hashCombine(seed, static_cast<int>(info.m_borderColor));
+	hashCombine(seed, info.m_unnormalizedCoordinates);
+
+	return seed;
+}
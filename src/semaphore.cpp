@@ -1,8 +1,12 @@
+#include <array>
+#include <cassert>
 #include "ignis/semaphore.hpp"
 #include "exceptions.hpp"
 
 using namespace ignis;
 
+static constexpr size_t MAX_WAIT_SEMAPHORES = 32;
+
 Semaphore::Semaphore(const VkDevice device) : m_device(device) {
 	VkSemaphoreCreateInfo const semaphoreInfo{
 		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
@@ -16,3 +20,106 @@ Semaphore::Semaphore(const VkDevice device) : m_device(device) {
 Semaphore::~Semaphore() {
 	vkDestroySemaphore(m_device, m_semaphore, nullptr);
 }
+
+TimelineSemaphore::TimelineSemaphore(const VkDevice device, uint64_t initialValue)
+	: m_device(device) {
+	VkSemaphoreTypeCreateInfo const typeInfo{
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+		.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+		.initialValue = initialValue,
+	};
+
+	VkSemaphoreCreateInfo const semaphoreInfo{
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+		.pNext = &typeInfo,
+	};
+
+	THROW_VULKAN_ERROR(
+		vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_semaphore),
+		"Failed to create timeline semaphore");
+}
+
+TimelineSemaphore::~TimelineSemaphore() {
+	vkDestroySemaphore(m_device, m_semaphore, nullptr);
+}
+
+uint64_t TimelineSemaphore::getValue() const {
+	uint64_t value{0};
+
+	THROW_VULKAN_ERROR(vkGetSemaphoreCounterValue(m_device, m_semaphore, &value),
+					   "Failed to get timeline semaphore value");
+
+	return value;
+}
+
+bool TimelineSemaphore::wait(uint64_t value, uint64_t timeout) const {
+	VkSemaphoreWaitInfo const waitInfo{
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+		.semaphoreCount = 1,
+		.pSemaphores = &m_semaphore,
+		.pValues = &value,
+	};
+
+	const VkResult result = vkWaitSemaphores(m_device, &waitInfo, timeout);
+
+	if (result == VK_TIMEOUT) {
+		return false;
+	}
+
+	THROW_VULKAN_ERROR(result, "Failed to wait for timeline semaphore");
+
+	return true;
+}
+
+void TimelineSemaphore::signal(uint64_t value) const {
+	VkSemaphoreSignalInfo const signalInfo{
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+		.semaphore = m_semaphore,
+		.value = value,
+	};
+
+	THROW_VULKAN_ERROR(vkSignalSemaphore(m_device, &signalInfo),
+					   "Failed to signal timeline semaphore");
+}
+
+bool TimelineSemaphore::wait(std::span<const TimelineSemaphore* const> semaphores,
+							 std::span<const uint64_t> values,
+							 bool waitAll,
+							 uint64_t timeout) {
+	assert(semaphores.size() == values.size() && "Mismatched wait values");
+
+	if (semaphores.empty()) {
+		return true;
+	}
+
+	THROW_ERROR(semaphores.size() > MAX_WAIT_SEMAPHORES,
+				"Too many timeline semaphores to wait for");
+
+	std::array<VkSemaphore, MAX_WAIT_SEMAPHORES> handles;
+
+	for (size_t i = 0; i < semaphores.size(); i++) {
+		assert(semaphores[i]->m_device == semaphores[0]->m_device &&
+			   "Timeline semaphores belong to different devices");
+
+		handles[i] = semaphores[i]->getHandle();
+	}
+
+	VkSemaphoreWaitInfo const waitInfo{
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+		.flags = waitAll ? VkSemaphoreWaitFlags{0} : VK_SEMAPHORE_WAIT_ANY_BIT,
+		.semaphoreCount = static_cast<uint32_t>(semaphores.size()),
+		.pSemaphores = handles.data(),
+		.pValues = values.data(),
+	};
+
+	const VkResult result =
+		vkWaitSemaphores(semaphores[0]->m_device, &waitInfo, timeout);
+
+	if (result == VK_TIMEOUT) {
+		return false;
+	}
+
+	THROW_VULKAN_ERROR(result, "Failed to wait for timeline semaphores");
+
+	return true;
+}
@@ -1,4 +1,5 @@
 #include "ignis/shader.hpp"
+#include "spirv_reflection.hpp"
 #include "exceptions.hpp"
 
 #include <fstream>
@@ -8,12 +9,20 @@ using namespace ignis;
 Shader::Shader(const VkDevice device,
 			   const void* code,
 			   VkDeviceSize codeSize,
-			   VkShaderStageFlagBits stage,
-			   VkDeviceSize pushConstantSize)
-	: m_device(device), m_pushConstantSize(pushConstantSize), m_stage(stage) {
+			   VkShaderStageFlagBits stage)
+	: m_device(device), m_stage(stage) {
 	THROW_ERROR(codeSize % 4 != 0,
 				"SPIR-V shader code size must be a multiple of 4");
 
+	SpirvReflection reflection = reflectSpirv(
+		{static_cast<const uint32_t*>(code), static_cast<size_t>(codeSize / 4)},
+		stage);
+
+	m_pushConstantSize = reflection.pushConstantSize;
+	m_entryPoint = std::move(reflection.entryPoint);
+	m_specializationConstants = std::move(reflection.specializationConstants);
+	m_workgroupSize = reflection.workgroupSize;
+
 	const VkShaderModuleCreateInfo moduleCreateInfo{
 		.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
 		.codeSize = codeSize,
@@ -27,8 +36,7 @@ Shader::Shader(const VkDevice device,
 
 Shader Shader::fromFile(VkDevice device,
 						const std::string& path,
-						VkShaderStageFlagBits stage,
-						VkDeviceSize pushConstantSize) {
+						VkShaderStageFlagBits stage) {
 	std::ifstream file(path, std::ios::ate | std::ios::binary);
 
 	THROW_ERROR(!file.is_open(), "Failed to open shader file " + path);
@@ -39,8 +47,7 @@ Shader Shader::fromFile(VkDevice device,
 	file.read(reinterpret_cast<char*>(code.data()), fileSize);
 	file.close();
 
-	return Shader(device, code.data(), static_cast<VkDeviceSize>(fileSize), stage,
-				  pushConstantSize);
+	return Shader(device, code.data(), static_cast<VkDeviceSize>(fileSize), stage);
 }
 
 Shader::~Shader() {
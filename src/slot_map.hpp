@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "ignis/types.hpp"
+
+namespace ignis {
+
+// Generational slot map. Values live in fixed size pages, so they never move
+// and references stay valid while other slots are inserted or erased. Freed
+// indices are recycled and every reuse bumps the slot generation, which is
+// stored in the high bits of the id. Maps sharing a descriptor array set
+// tell their ids apart with the tag bit.
+template <typename T>
+class SlotMap {
+public:
+	static constexpr uint32_t GENERATION_MASK =
+		(1u << (31 - IGNIS_RESOURCE_INDEX_BITS)) - 1;
+
+	// the last index is never handed out, so no id can be UINT32_MAX
+	static constexpr uint32_t MAX_CAPACITY = IGNIS_RESOURCE_INDEX_MASK;
+
+	SlotMap(uint32_t capacity, bool tagged = false)
+		: m_capacity(std::min(capacity, MAX_CAPACITY)),
+		  m_tag(tagged ? IGNIS_RESOURCE_TAG_BIT : 0) {}
+
+	// only hands out indices below limit, an index over it is left for
+	// callers with a larger limit instead of failing every later insert
+	uint32_t insert(T&& value, uint32_t limit = MAX_CAPACITY) {
+		limit = std::min(limit, m_capacity);
+
+		uint32_t index = 0;
+
+		// most recently freed first, its page is likely still in cache
+		auto it = std::find_if(m_freeIndices.rbegin(), m_freeIndices.rend(),
+							   [limit](uint32_t i) { return i < limit; });
+
+		if (it != m_freeIndices.rend()) {
+			index = *it;
+			m_freeIndices.erase(std::next(it).base());
+		} else {
+			if (m_nextIndex >= limit) {
+				return UINT32_MAX;
+			}
+
+			index = m_nextIndex++;
+
+			if ((index >> PAGE_BITS) >= m_pages.size()) {
+				m_pages.push_back(std::make_unique<Slot[]>(PAGE_SIZE));
+			}
+		}
+
+		Slot& slot = getSlot(index);
+		slot.value.emplace(std::move(value));
+		m_size++;
+
+		return m_tag | (slot.generation << IGNIS_RESOURCE_INDEX_BITS) | index;
+	}
+
+	T* get(uint32_t id) const {
+		const uint32_t index = getResourceIndex(id);
+
+		if ((id & IGNIS_RESOURCE_TAG_BIT) != m_tag || index >= m_nextIndex) {
+			return nullptr;
+		}
+
+		Slot& slot = getSlot(index);
+		const uint32_t generation =
+			(id >> IGNIS_RESOURCE_INDEX_BITS) & GENERATION_MASK;
+
+		if (!slot.value || slot.generation != generation) {
+			return nullptr;
+		}
+
+		return &*slot.value;
+	}
+
+	bool erase(uint32_t id) {
+		if (get(id) == nullptr) {
+			return false;
+		}
+
+		const uint32_t index = getResourceIndex(id);
+
+		Slot& slot = getSlot(index);
+		slot.value.reset();
+		slot.generation = (slot.generation + 1) & GENERATION_MASK;
+
+		m_freeIndices.push_back(index);
+		m_size--;
+
+		return true;
+	}
+
+	uint32_t size() const { return m_size; }
+
+	uint32_t capacity() const { return m_capacity; }
+
+private:
+	static constexpr uint32_t PAGE_BITS = 8;
+	static constexpr uint32_t PAGE_SIZE = 1u << PAGE_BITS;
+
+	struct Slot {
+		std::optional<T> value;
+		uint32_t generation{0};
+	};
+
+	Slot& getSlot(uint32_t index) const {
+		assert(index < m_nextIndex && "Slot index out of range");
+		return m_pages[index >> PAGE_BITS][index & (PAGE_SIZE - 1)];
+	}
+
+	std::vector<std::unique_ptr<Slot[]>> m_pages;
+	std::vector<uint32_t> m_freeIndices;
+	uint32_t m_nextIndex{0};
+	uint32_t m_size{0};
+	uint32_t m_capacity;
+	uint32_t m_tag;
+};
+
+}  // namespace ignis
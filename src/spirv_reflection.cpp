@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include "spirv_reflection.hpp"
+#include "exceptions.hpp"
+
+using namespace ignis;
+
+static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+static constexpr uint32_t SPIRV_HEADER_WORD_COUNT = 5;
+
+// the subset of the SPIR-V grammar we read
+enum SpirvOp : uint32_t {
+	OpEntryPoint = 15,
+	OpExecutionMode = 16,
+	OpTypeBool = 20,
+	OpTypeInt = 21,
+	OpTypeFloat = 22,
+	OpTypeVector = 23,
+	OpTypeMatrix = 24,
+	OpTypeArray = 28,
+	OpTypeStruct = 30,
+	OpTypePointer = 32,
+	OpConstantTrue = 41,
+	OpConstantFalse = 42,
+	OpConstant = 43,
+	OpConstantComposite = 44,
+	OpSpecConstantTrue = 48,
+	OpSpecConstantFalse = 49,
+	OpSpecConstant = 50,
+	OpSpecConstantComposite = 51,
+	OpVariable = 59,
+	OpDecorate = 71,
+	OpMemberDecorate = 72,
+	OpExecutionModeId = 331,
+};
+
+enum SpirvDecoration : uint32_t {
+	DecorationSpecId = 1,
+	DecorationRowMajor = 4,
+	DecorationArrayStride = 6,
+	DecorationMatrixStride = 7,
+	DecorationBuiltIn = 11,
+	DecorationOffset = 35,
+};
+
+static constexpr uint32_t BUILTIN_WORKGROUP_SIZE = 25;
+static constexpr uint32_t EXECUTION_MODE_LOCAL_SIZE = 17;
+static constexpr uint32_t EXECUTION_MODE_LOCAL_SIZE_ID = 38;
+static constexpr uint32_t STORAGE_CLASS_PUSH_CONSTANT = 9;
+
+static uint32_t getExecutionModel(VkShaderStageFlagBits stage) {
+	switch (stage) {
+		case VK_SHADER_STAGE_VERTEX_BIT:
+			return 0;
+		case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
+			return 1;
+		case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
+			return 2;
+		case VK_SHADER_STAGE_GEOMETRY_BIT:
+			return 3;
+		case VK_SHADER_STAGE_FRAGMENT_BIT:
+			return 4;
+		case VK_SHADER_STAGE_COMPUTE_BIT:
+			return 5;
+		case VK_SHADER_STAGE_TASK_BIT_EXT:
+			return 5364;
+		case VK_SHADER_STAGE_MESH_BIT_EXT:
+			return 5365;
+		default:
+			THROW_ERROR(true, "Unsupported shader stage");
+	}
+}
+
+// literal strings are nul terminated and packed little endian in words
+static std::string readString(std::span<const uint32_t> words) {
+	std::string string;
+
+	for (size_t i = 0; i < words.size(); i++) {
+		for (uint32_t byte = 0; byte < 4; byte++) {
+			const char c = static_cast<char>((words[i] >> (byte * 8)) & 0xFF);
+
+			if (c == '\0') {
+				return string;
+			}
+
+			string.push_back(c);
+		}
+	}
+
+	THROW_ERROR(true, "Unterminated SPIR-V string");
+}
+
+namespace {
+
+class SpirvReflector {
+public:
+	SpirvReflector(std::span<const uint32_t> code, VkShaderStageFlagBits stage);
+
+	SpirvReflection reflect();
+
+private:
+	struct Instruction {
+		uint32_t opcode;
+		std::span<const uint32_t> operands;
+	};
+
+	struct Member {
+		uint32_t offset{0};
+		uint32_t matrixStride{0};
+		bool rowMajor{false};
+	};
+
+	struct Decorations {
+		std::optional<uint32_t> specId;
+		uint32_t arrayStride{0};
+		bool isWorkgroupSize{false};
+		std::unordered_map<uint32_t, Member> members;
+	};
+
+	void parseInstruction(const Instruction&);
+
+	const Instruction& getDefinition(uint32_t id) const;
+
+	uint32_t getConstantValue(uint32_t id) const;
+
+	uint32_t getTypeSize(uint32_t typeId, const Member* member = nullptr) const;
+
+private:
+	std::span<const uint32_t> m_code;
+	uint32_t m_executionModel;
+
+	std::optional<uint32_t> m_entryPointId;
+	std::string m_entryPointName;
+	std::optional<std::array<uint32_t, 3>> m_localSize;
+	std::optional<std::array<uint32_t, 3>> m_localSizeIds;
+
+	// types and constants by result id
+	std::unordered_map<uint32_t, Instruction> m_definitions;
+	std::unordered_map<uint32_t, Decorations> m_decorations;
+	std::vector<uint32_t> m_pushConstantTypes;
+	std::vector<uint32_t> m_specConstants;
+};
+
+}  // namespace
+
+SpirvReflector::SpirvReflector(std::span<const uint32_t> code,
+							   VkShaderStageFlagBits stage)
+	: m_code(code), m_executionModel(getExecutionModel(stage)) {}
+
+SpirvReflection SpirvReflector::reflect() {
+	THROW_ERROR(m_code.size() < SPIRV_HEADER_WORD_COUNT || m_code[0] != SPIRV_MAGIC,
+				"Invalid SPIR-V module");
+
+	size_t offset = SPIRV_HEADER_WORD_COUNT;
+
+	while (offset < m_code.size()) {
+		const uint32_t wordCount = m_code[offset] >> 16;
+
+		THROW_ERROR(wordCount == 0 || offset + wordCount > m_code.size(),
+					"Truncated SPIR-V instruction");
+
+		parseInstruction({
+			.opcode = m_code[offset] & 0xFFFF,
+			.operands = m_code.subspan(offset + 1, wordCount - 1),
+		});
+
+		offset += wordCount;
+	}
+
+	THROW_ERROR(!m_entryPointId.has_value(),
+				"The SPIR-V module has no entry point for the shader stage");
+
+	SpirvReflection reflection{.entryPoint = m_entryPointName};
+
+	for (auto typeId : m_pushConstantTypes) {
+		reflection.pushConstantSize =
+			std::max(reflection.pushConstantSize, getTypeSize(typeId));
+	}
+
+	// push constant ranges are made of words
+	reflection.pushConstantSize = (reflection.pushConstantSize + 3) & ~3u;
+
+	for (auto id : m_specConstants) {
+		auto it = m_decorations.find(id);
+
+		// only constants with a SpecId can be set from the API
+		if (it == m_decorations.end() || !it->second.specId) {
+			continue;
+		}
+
+		const Instruction& constant = getDefinition(id);
+		const Instruction& type = getDefinition(constant.operands[0]);
+
+		SpecializationConstant specConstant{
+			.id = *it->second.specId,
+			.size = type.opcode == OpTypeBool ? 4 : type.operands[1] / 8,
+		};
+
+		if (constant.opcode == OpSpecConstant) {
+			specConstant.defaultValue = constant.operands[2];
+
+			if (constant.operands.size() > 3) {
+				specConstant.defaultValue |=
+					static_cast<uint64_t>(constant.operands[3]) << 32;
+			}
+		} else {
+			specConstant.defaultValue = constant.opcode == OpSpecConstantTrue;
+		}
+
+		reflection.specializationConstants.push_back(specConstant);
+	}
+
+	std::sort(reflection.specializationConstants.begin(),
+			  reflection.specializationConstants.end(),
+			  [](const auto& a, const auto& b) { return a.id < b.id; });
+
+	if (m_localSize) {
+		reflection.workgroupSize = *m_localSize;
+	}
+
+	if (m_localSizeIds) {
+		for (uint32_t i = 0; i < 3; i++) {
+			reflection.workgroupSize[i] = getConstantValue((*m_localSizeIds)[i]);
+		}
+	}
+
+	// the WorkgroupSize built-in takes precedence over the execution mode
+	for (const auto& [id, decorations] : m_decorations) {
+		if (!decorations.isWorkgroupSize) {
+			continue;
+		}
+
+		const Instruction& composite = getDefinition(id);
+
+		THROW_ERROR(composite.operands.size() < 5, "Invalid workgroup size");
+
+		for (uint32_t i = 0; i < 3; i++) {
+			reflection.workgroupSize[i] =
+				getConstantValue(composite.operands[2 + i]);
+		}
+	}
+
+	return reflection;
+}
+
+void SpirvReflector::parseInstruction(const Instruction& instruction) {
+	const auto& operands = instruction.operands;
+
+	switch (instruction.opcode) {
+		case OpEntryPoint: {
+			THROW_ERROR(operands.size() < 3, "Invalid SPIR-V entry point");
+
+			if (operands[0] != m_executionModel || m_entryPointId) {
+				break;
+			}
+
+			m_entryPointId = operands[1];
+			m_entryPointName = readString(operands.subspan(2));
+			break;
+		}
+
+		case OpExecutionMode:
+		case OpExecutionModeId: {
+			if (operands.size() < 5 || operands[0] != m_entryPointId) {
+				break;
+			}
+
+			const std::array<uint32_t, 3> size{operands[2], operands[3],
+											   operands[4]};
+
+			if (operands[1] == EXECUTION_MODE_LOCAL_SIZE) {
+				m_localSize = size;
+			} else if (operands[1] == EXECUTION_MODE_LOCAL_SIZE_ID) {
+				m_localSizeIds = size;
+			}
+			break;
+		}
+
+		case OpDecorate: {
+			if (operands.size() < 2) {
+				break;
+			}
+
+			Decorations& decorations = m_decorations[operands[0]];
+
+			if (operands[1] == DecorationSpecId && operands.size() > 2) {
+				decorations.specId = operands[2];
+			} else if (operands[1] == DecorationArrayStride && operands.size() > 2) {
+				decorations.arrayStride = operands[2];
+			} else if (operands[1] == DecorationBuiltIn && operands.size() > 2) {
+				decorations.isWorkgroupSize = operands[2] == BUILTIN_WORKGROUP_SIZE;
+			}
+			break;
+		}
+
+		case OpMemberDecorate: {
+			if (operands.size() < 3) {
+				break;
+			}
+
+			Member& member = m_decorations[operands[0]].members[operands[1]];
+
+			if (operands[2] == DecorationOffset && operands.size() > 3) {
+				member.offset = operands[3];
+			} else if (operands[2] == DecorationMatrixStride &&
+					   operands.size() > 3) {
+				member.matrixStride = operands[3];
+			} else if (operands[2] == DecorationRowMajor) {
+				member.rowMajor = true;
+			}
+			break;
+		}
+
+		case OpTypeBool:
+		case OpTypeInt:
+		case OpTypeFloat:
+		case OpTypeVector:
+		case OpTypeMatrix:
+		case OpTypeArray:
+		case OpTypeStruct:
+		case OpTypePointer:
+			THROW_ERROR(operands.empty(), "Invalid SPIR-V type");
+			m_definitions[operands[0]] = instruction;
+			break;
+
+		case OpSpecConstantTrue:
+		case OpSpecConstantFalse:
+		case OpSpecConstant:
+			m_specConstants.push_back(operands[1]);
+			[[fallthrough]];
+
+		case OpConstantTrue:
+		case OpConstantFalse:
+		case OpConstant:
+		case OpConstantComposite:
+		case OpSpecConstantComposite:
+			THROW_ERROR(operands.size() < 2, "Invalid SPIR-V constant");
+			m_definitions[operands[1]] = instruction;
+			break;
+
+		case OpVariable: {
+			if (operands.size() < 3 || operands[2] != STORAGE_CLASS_PUSH_CONSTANT) {
+				break;
+			}
+
+			// the result type is a pointer to the block
+			const Instruction& pointer = getDefinition(operands[0]);
+
+			THROW_ERROR(
+				pointer.opcode != OpTypePointer || pointer.operands.size() < 3,
+				"Invalid push constant variable");
+
+			m_pushConstantTypes.push_back(pointer.operands[2]);
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+const SpirvReflector::Instruction& SpirvReflector::getDefinition(uint32_t id) const {
+	auto it = m_definitions.find(id);
+
+	THROW_ERROR(it == m_definitions.end(), "Undefined SPIR-V id");
+
+	return it->second;
+}
+
+// spec constants resolve to their default value
+uint32_t SpirvReflector::getConstantValue(uint32_t id) const {
+	const Instruction& constant = getDefinition(id);
+
+	switch (constant.opcode) {
+		case OpConstantTrue:
+		case OpSpecConstantTrue:
+			return 1;
+
+		case OpConstantFalse:
+		case OpSpecConstantFalse:
+			return 0;
+
+		case OpConstant:
+		case OpSpecConstant:
+			THROW_ERROR(constant.operands.size() < 3, "Invalid SPIR-V constant");
+			return constant.operands[2];
+
+		default:
+			THROW_ERROR(true, "Expected a scalar SPIR-V constant");
+	}
+}
+
+// the size a type takes in a block with explicit layout; the member carries the
+// matrix layout, which SPIR-V decorates on the struct member
+uint32_t SpirvReflector::getTypeSize(uint32_t typeId, const Member* member) const {
+	const Instruction& type = getDefinition(typeId);
+	const auto& operands = type.operands;
+
+	switch (type.opcode) {
+		case OpTypeBool:
+			return 4;
+
+		case OpTypeInt:
+		case OpTypeFloat:
+			THROW_ERROR(operands.size() < 2, "Invalid SPIR-V scalar type");
+			return operands[1] / 8;
+
+		case OpTypeVector:
+			THROW_ERROR(operands.size() < 3, "Invalid SPIR-V vector type");
+			return operands[2] * getTypeSize(operands[1]);
+
+		case OpTypeMatrix: {
+			THROW_ERROR(operands.size() < 3, "Invalid SPIR-V matrix type");
+
+			const uint32_t columnCount = operands[2];
+
+			if (member == nullptr || member->matrixStride == 0) {
+				return columnCount * getTypeSize(operands[1]);
+			}
+
+			// a row major matrix is laid out as its rows
+			const uint32_t vectorCount = member->rowMajor
+											 ? getDefinition(operands[1]).operands[2]
+											 : columnCount;
+
+			return vectorCount * member->matrixStride;
+		}
+
+		case OpTypeArray: {
+			THROW_ERROR(operands.size() < 3, "Invalid SPIR-V array type");
+
+			auto it = m_decorations.find(typeId);
+
+			const bool hasStride =
+				it != m_decorations.end() && it->second.arrayStride != 0;
+
+			const uint32_t stride = hasStride ? it->second.arrayStride
+											  : getTypeSize(operands[1], member);
+
+			return getConstantValue(operands[2]) * stride;
+		}
+
+		case OpTypeStruct: {
+			auto it = m_decorations.find(typeId);
+
+			uint32_t size = 0;
+
+			for (uint32_t i = 1; i < operands.size(); i++) {
+				const Member* structMember = nullptr;
+
+				if (it != m_decorations.end()) {
+					auto memberIt = it->second.members.find(i - 1);
+
+					if (memberIt != it->second.members.end()) {
+						structMember = &memberIt->second;
+					}
+				}
+
+				const uint32_t offset = structMember ? structMember->offset : size;
+
+				size = std::max(size,
+								offset + getTypeSize(operands[i], structMember));
+			}
+
+			return size;
+		}
+
+		// buffer device addresses
+		case OpTypePointer:
+			return 8;
+
+		default:
+			THROW_ERROR(true, "Unsupported type in a push constant block");
+	}
+}
+
+SpirvReflection ignis::reflectSpirv(std::span<const uint32_t> code,
+									VkShaderStageFlagBits stage) {
+	return SpirvReflector(code, stage).reflect();
+}
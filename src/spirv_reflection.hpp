@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+#include "ignis/shader.hpp"
+
+namespace ignis {
+
+struct SpirvReflection {
+	std::string entryPoint;
+	uint32_t pushConstantSize{0};
+	std::vector<SpecializationConstant> specializationConstants;
+	std::array<uint32_t, 3> workgroupSize{1, 1, 1};
+};
+
+// A single pass over the module, enough for what the pipelines need: the entry
+// point of the stage, the end of the push constant block (explicit offsets
+// included), the specialization constants with their defaults and the local
+// size of compute shaders, resolved through spec constants when it uses them.
+// Throws on malformed code or when no entry point matches the stage.
+SpirvReflection reflectSpirv(std::span<const uint32_t> code,
+							 VkShaderStageFlagBits stage);
+
+}  // namespace ignis
@@ -0,0 +1,77 @@
+#include <cassert>
+#include "staging_ring.hpp"
+
+using namespace ignis;
+
+Device::StagingRing::StagingRing(VmaAllocator_T* allocator, VkDeviceSize size)
+	: m_buffer(Buffer::allocateStagingBuffer(allocator, size)) {
+	assert(m_buffer.getMappedPointer() != nullptr && "Staging ring is not mapped");
+}
+
+StagingAllocation Device::StagingRing::allocate(VkDeviceSize size,
+												VkDeviceSize alignment) {
+	assert(size > 0 && "Staging allocation size must be greater than 0");
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0 &&
+		   "Staging alignment must be a power of 2");
+
+	std::lock_guard lock(m_mutex);
+
+	const VkDeviceSize capacity = m_buffer.getSize();
+
+	if (m_regions.empty()) {
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	VkDeviceSize offset = (m_head + alignment - 1) & ~(alignment - 1);
+
+	if (m_regions.empty() || m_head > m_tail) {
+		// free space is [head, capacity) and [0, tail)
+		if (offset + size > capacity) {
+			if (size > m_tail) {
+				return {};
+			}
+
+			offset = 0;
+		}
+	} else if (offset + size > m_tail) {
+		// free space is [head, tail)
+		return {};
+	}
+
+	m_head = offset + size;
+	m_regions.push_back({.offset = offset, .released = false});
+
+	if (m_regions.size() == 1) {
+		m_tail = offset;
+	}
+
+	return {
+		.buffer = m_buffer.getHandle(),
+		.offset = offset,
+		.size = size,
+		.mappedData = static_cast<char*>(m_buffer.getMappedPointer()) + offset,
+	};
+}
+
+void Device::StagingRing::release(const StagingAllocation& allocation) {
+	assert(allocation.buffer == m_buffer.getHandle() &&
+		   "Allocation does not belong to the staging ring");
+
+	std::lock_guard lock(m_mutex);
+
+	for (auto& region : m_regions) {
+		if (region.offset == allocation.offset && !region.released) {
+			region.released = true;
+			break;
+		}
+	}
+
+	while (!m_regions.empty() && m_regions.front().released) {
+		m_regions.pop_front();
+	}
+
+	if (!m_regions.empty()) {
+		m_tail = m_regions.front().offset;
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include "ignis/device.hpp"
+#include "ignis/buffer.hpp"
+
+namespace ignis {
+
+// Linear ring over a single persistently mapped staging buffer. Regions are
+// handed out in order and reclaimed from the tail once released, so releases
+// can happen out of order without fragmenting the arena.
+class Device::StagingRing {
+public:
+	StagingRing(VmaAllocator_T*, VkDeviceSize size);
+
+	~StagingRing() = default;
+
+	// returns an allocation with a null buffer if there is no room left
+	StagingAllocation allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+	void release(const StagingAllocation&);
+
+	auto getSize() const { return m_buffer.getSize(); }
+
+private:
+	struct Region {
+		VkDeviceSize offset;
+		bool released;
+	};
+
+	Buffer m_buffer;
+	VkDeviceSize m_head{0};
+	VkDeviceSize m_tail{0};
+	std::deque<Region> m_regions;
+	std::mutex m_mutex;
+
+public:
+	StagingRing(const StagingRing&) = delete;
+	StagingRing(StagingRing&&) = delete;
+	StagingRing& operator=(const StagingRing&) = delete;
+	StagingRing& operator=(StagingRing&&) = delete;
+};
+
+}  // namespace ignis
@@ -4,6 +4,7 @@
 #include "ignis/image.hpp"
 #include "ignis/semaphore.hpp"
 #include "exceptions.hpp"
+#include "trace.hpp"
 
 using namespace ignis;
 
@@ -154,6 +155,8 @@ Swapchain::~Swapchain() {
 }
 
 Image& Swapchain::acquireNextImage(const Semaphore* signalSemaphore) {
+	IGNIS_TRACE_SCOPE("Swapchain::acquireNextImage");
+
 	THROW_ERROR(vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX,
 									  signalSemaphore->getHandle(), VK_NULL_HANDLE,
 									  &m_currentImageIndex) != VK_SUCCESS,
@@ -163,6 +166,8 @@ Image& Swapchain::acquireNextImage(const Semaphore* signalSemaphore) {
 }
 
 void Swapchain::presentCurrent(const PresentInfo& info) const {
+	IGNIS_TRACE_SCOPE("Swapchain::presentCurrent");
+
 	assert(info.presentationQueue != nullptr && "Presentation queue is not set");
 
 	std::vector<VkSemaphore> waitSemaphores;
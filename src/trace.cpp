@@ -0,0 +1,191 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include "trace.hpp"
+
+namespace ignis::trace {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+struct Event {
+	const char* name;
+	const char* category;
+	uint64_t beginNs;
+	uint64_t endNs;
+	uint32_t process;
+	uint32_t track;
+	char phase;
+};
+
+struct Tracer {
+	std::mutex mutex;
+	std::string path;
+	uint64_t startNs{0};
+	std::vector<Event> events;
+	std::atomic<uint32_t> threadCount{0};
+};
+
+Tracer& getTracer() {
+	static Tracer tracer;
+	return tracer;
+}
+
+uint32_t getThreadTrack() {
+	thread_local const uint32_t track = getTracer().threadCount++;
+	return track;
+}
+
+void writeString(std::ofstream& file, const char* string) {
+	file << '"';
+
+	for (const char* c = string; *c != '\0'; c++) {
+		const auto byte = static_cast<unsigned char>(*c);
+
+		if (*c == '"' || *c == '\\') {
+			file << '\\' << *c;
+		} else if (*c == '\n') {
+			file << "\\n";
+		} else if (*c == '\t') {
+			file << "\\t";
+		} else if (byte < 0x20) {
+			// json forbids raw control characters in strings
+			char escaped[8];
+			std::snprintf(escaped, sizeof(escaped), "\\u%04x", byte);
+			file << escaped;
+		} else {
+			file << *c;
+		}
+	}
+
+	file << '"';
+}
+
+void writeTime(std::ofstream& file, uint64_t ns, uint64_t startNs) {
+	const int64_t relative =
+		static_cast<int64_t>(ns) - static_cast<int64_t>(startNs);
+
+	file << static_cast<double>(relative) / 1000.0;
+}
+
+}  // namespace
+
+uint64_t now() {
+	const auto time = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+}
+
+void start(const std::string& path) {
+	Tracer& tracer = getTracer();
+
+	std::lock_guard lock(tracer.mutex);
+
+	tracer.path = path;
+	tracer.startNs = now();
+	tracer.events.clear();
+	tracer.events.reserve(64 * 1024);
+
+	g_enabled.store(true, std::memory_order_relaxed);
+}
+
+void stop() {
+	if (!isEnabled()) {
+		return;
+	}
+
+	g_enabled.store(false, std::memory_order_relaxed);
+
+	Tracer& tracer = getTracer();
+
+	std::lock_guard lock(tracer.mutex);
+
+	std::ofstream file(tracer.path);
+
+	// called from the device destructor, so we can't throw
+	if (!file.is_open()) {
+		std::cerr << "ignis::trace::stop: failed to open " << tracer.path
+				  << std::endl;
+		tracer.events.clear();
+		return;
+	}
+
+	// microseconds with ns resolution, the default format keeps 6 digits only
+	file << std::fixed << std::setprecision(3);
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << CPU_PROCESS
+		 << ",\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << GPU_PROCESS
+		 << ",\"args\":{\"name\":\"GPU\"}}";
+
+	for (const auto& event : tracer.events) {
+		file << ",\n{\"name\":";
+		writeString(file, event.name);
+		file << ",\"cat\":";
+		writeString(file, event.category);
+		file << ",\"ph\":\"" << event.phase << "\",\"ts\":";
+		writeTime(file, event.beginNs, tracer.startNs);
+
+		if (event.phase == 'X') {
+			file << ",\"dur\":"
+				 << static_cast<double>(event.endNs - event.beginNs) / 1000.0;
+		} else {
+			file << ",\"s\":\"g\"";
+		}
+
+		file << ",\"pid\":" << event.process << ",\"tid\":" << event.track << "}";
+	}
+
+	file << "\n]}\n";
+
+	tracer.events.clear();
+}
+
+void addSpan(const char* name,
+			 const char* category,
+			 uint64_t beginNs,
+			 uint64_t endNs,
+			 uint32_t process,
+			 uint32_t track) {
+	if (process == CPU_PROCESS) {
+		track = getThreadTrack();
+	}
+
+	Tracer& tracer = getTracer();
+
+	std::lock_guard lock(tracer.mutex);
+
+	tracer.events.push_back({
+		.name = name,
+		.category = category,
+		.beginNs = beginNs,
+		.endNs = endNs < beginNs ? beginNs : endNs,
+		.process = process,
+		.track = track,
+		.phase = 'X',
+	});
+}
+
+void addInstant(const char* name, const char* category, uint64_t timeNs) {
+	Tracer& tracer = getTracer();
+
+	std::lock_guard lock(tracer.mutex);
+
+	tracer.events.push_back({
+		.name = name,
+		.category = category,
+		.beginNs = timeNs,
+		.endNs = timeNs,
+		.process = CPU_PROCESS,
+		.track = 0,
+		.phase = 'i',
+	});
+}
+
+}  // namespace ignis::trace
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Note 1: the tracer is global, it is started and written by the device
+// Note 2: event names and categories are not copied, they have to be literals
+// Note 3: when tracing is disabled a scope costs a relaxed atomic load
+
+namespace ignis::trace {
+
+inline constexpr uint32_t CPU_PROCESS = 0;
+inline constexpr uint32_t GPU_PROCESS = 1;
+
+extern std::atomic<bool> g_enabled;
+
+inline bool isEnabled() {
+	return g_enabled.load(std::memory_order_relaxed);
+}
+
+// nanoseconds on the steady clock
+uint64_t now();
+
+void start(const std::string& path);
+
+// writes the chrome trace-event json and disables tracing
+void stop();
+
+// the track of a cpu span is always the calling thread
+void addSpan(const char* name,
+			 const char* category,
+			 uint64_t beginNs,
+			 uint64_t endNs,
+			 uint32_t process = CPU_PROCESS,
+			 uint32_t track = 0);
+
+void addInstant(const char* name, const char* category, uint64_t timeNs);
+
+// a span on the calling thread
+class Scope {
+public:
+	Scope(const char* name, const char* category)
+		: m_name(name),
+		  m_category(category),
+		  m_begin(isEnabled() ? now() : 0) {}
+
+	~Scope() {
+		if (m_begin != 0 && isEnabled()) {
+			addSpan(m_name, m_category, m_begin, now());
+		}
+	}
+
+private:
+	const char* m_name;
+	const char* m_category;
+	uint64_t m_begin;
+
+public:
+	Scope(const Scope&) = delete;
+	Scope(Scope&&) = delete;
+	Scope& operator=(const Scope&) = delete;
+	Scope& operator=(Scope&&) = delete;
+};
+
+}  // namespace ignis::trace
+
+#define IGNIS_TRACE_CONCAT_IMPL(a, b) a##b
+#define IGNIS_TRACE_CONCAT(a, b) IGNIS_TRACE_CONCAT_IMPL(a, b)
+
+#define IGNIS_TRACE_SCOPE(name)                                        \
+	ignis::trace::Scope IGNIS_TRACE_CONCAT(ignisTraceScope, __LINE__)( \
+		(name), "ignis")
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <cassert>
+#include "ignis/upload_queue.hpp"
+#include "ignis/command.hpp"
+#include "ignis/command_pool.hpp"
+#include "ignis/buffer.hpp"
+#include "ignis/image.hpp"
+#include "ignis/semaphore.hpp"
+#include "exceptions.hpp"
+
+using namespace ignis;
+
+static VkImageLayout getUploadedLayout(const Image& image) {
+	if (image.getOptimalLayout() != VK_IMAGE_LAYOUT_UNDEFINED) {
+		return image.getOptimalLayout();
+	}
+
+	if (image.getUsage() & VK_IMAGE_USAGE_SAMPLED_BIT) {
+		return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	}
+
+	if (image.getUsage() & VK_IMAGE_USAGE_STORAGE_BIT) {
+		return VK_IMAGE_LAYOUT_GENERAL;
+	}
+
+	return VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+}
+
+UploadQueue::UploadQueue(const UploadQueueCreateInfo& info)
+	: m_device(info.device),
+	  m_queue(m_device.getTransferQueue()),
+	  m_srcFamilyIndex(m_device.getTransferFamilyIndex()),
+	  m_dstFamilyIndex(m_device.getGraphicsFamilyIndex()) {
+	assert(info.batchesInFlight > 0 && "Invalid number of batches in flight");
+
+	m_batches.resize(info.batchesInFlight);
+
+	for (auto& batch : m_batches) {
+		batch.commandPool = std::make_unique<CommandPool>(CommandPoolCreateInfo{
+			.device = m_device,
+			.queue = m_queue,
+			.blockSize = 1,
+		});
+	}
+}
+
+UploadQueue::~UploadQueue() {
+	wait(m_lastSubmittedValue);
+
+	m_batches.clear();
+}
+
+Command& UploadQueue::getRecordingCommand() {
+	Batch& batch = m_batches[m_currentBatch];
+
+	if (!m_isRecording) {
+		// a batch is reused only once its previous submission has completed
+		wait(batch.value);
+
+		batch.commandPool->reset();
+		batch.command = &batch.commandPool->acquire();
+		batch.command->begin();
+		m_isRecording = true;
+	}
+
+	return *batch.command;
+}
+
+void UploadQueue::uploadBuffer(const Buffer& buffer,
+							   const void* data,
+							   VkDeviceSize offset,
+							   VkDeviceSize size) {
+	if (!size) {
+		size = buffer.getSize() - offset;
+	}
+
+	THROW_ERROR(offset + size > buffer.getSize(), "Out of bounds");
+
+	Command& command = getRecordingCommand();
+
+	command.updateBuffer(buffer, data, static_cast<uint32_t>(offset),
+						 static_cast<uint32_t>(size));
+
+	releaseBuffer(buffer, offset, size);
+}
+
+void UploadQueue::uploadBuffer(BufferId bufferId,
+							   const void* data,
+							   VkDeviceSize offset,
+							   VkDeviceSize size) {
+	uploadBuffer(m_device.getBuffer(bufferId), data, offset, size);
+}
+
+void UploadQueue::uploadImage(Image& image,
+							  const void* pixels,
+							  VkOffset2D imageOffset,
+							  VkExtent2D imageSize) {
+	Command& command = getRecordingCommand();
+
+	// the image may already have been uploaded in this batch
+	const bool pendingRelease = std::any_of(
+		m_releaseImageBarriers.begin(), m_releaseImageBarriers.end(),
+		[&](const auto& barrier) { return barrier.image == image.getHandle(); });
+
+	VkImageMemoryBarrier2 const toTransferDst{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+		.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+		.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+		.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		.oldLayout = pendingRelease ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+									: image.m_currentLayout,
+		.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = image.getHandle(),
+		.subresourceRange = {image.getAspect(), 0, 1, 0, 1},
+	};
+
+	VkDependencyInfo const dependencyInfo{
+		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		.imageMemoryBarrierCount = 1,
+		.pImageMemoryBarriers = &toTransferDst,
+	};
+
+	vkCmdPipelineBarrier2(command.getHandle(), &dependencyInfo);
+
+	image.m_currentLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+	command.updateImage(image, pixels, imageOffset, imageSize);
+
+	const VkImageLayout finalLayout = getUploadedLayout(image);
+
+	if (!pendingRelease) {
+		releaseImage(image, finalLayout);
+	}
+
+	// this is the layout the graphics queue sees after acquiring the image
+	image.m_currentLayout = finalLayout;
+}
+
+void UploadQueue::uploadImage(ImageId imageId,
+							  const void* pixels,
+							  VkOffset2D imageOffset,
+							  VkExtent2D imageSize) {
+	uploadImage(m_device.getImage(imageId), pixels, imageOffset, imageSize);
+}
+
+void UploadQueue::releaseBuffer(const Buffer& buffer,
+								VkDeviceSize offset,
+								VkDeviceSize size) {
+	// on the same family the semaphore wait already makes the copy visible
+	if (m_srcFamilyIndex == m_dstFamilyIndex) {
+		return;
+	}
+
+	m_releaseBufferBarriers.push_back({
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+		.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+		.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+		.dstAccessMask = VK_ACCESS_2_NONE,
+		.srcQueueFamilyIndex = m_srcFamilyIndex,
+		.dstQueueFamilyIndex = m_dstFamilyIndex,
+		.buffer = buffer.getHandle(),
+		.offset = offset,
+		.size = size,
+	});
+}
+
+void UploadQueue::releaseImage(const Image& image, VkImageLayout finalLayout) {
+	const bool ownershipTransfer = m_srcFamilyIndex != m_dstFamilyIndex;
+
+	// without an ownership transfer this is a plain layout transition
+	m_releaseImageBarriers.push_back({
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+		.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+		.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		.dstStageMask = ownershipTransfer ? VK_PIPELINE_STAGE_2_NONE
+										  : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		.dstAccessMask = ownershipTransfer ? VK_ACCESS_2_NONE
+										   : VK_ACCESS_2_MEMORY_READ_BIT,
+		.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		.newLayout = finalLayout,
+		.srcQueueFamilyIndex =
+			ownershipTransfer ? m_srcFamilyIndex : VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex =
+			ownershipTransfer ? m_dstFamilyIndex : VK_QUEUE_FAMILY_IGNORED,
+		.image = image.getHandle(),
+		.subresourceRange = {image.getAspect(), 0, 1, 0, 1},
+	});
+}
+
+uint64_t UploadQueue::flush(const Semaphore* signalSemaphore) {
+	if (!m_isRecording && signalSemaphore == nullptr) {
+		return m_lastSubmittedValue;
+	}
+
+	// an empty batch is still submitted to signal the semaphore
+	Command& command = getRecordingCommand();
+
+	if (!m_releaseBufferBarriers.empty() || !m_releaseImageBarriers.empty()) {
+		VkDependencyInfo const releaseInfo{
+			.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+			.bufferMemoryBarrierCount =
+				static_cast<uint32_t>(m_releaseBufferBarriers.size()),
+			.pBufferMemoryBarriers = m_releaseBufferBarriers.data(),
+			.imageMemoryBarrierCount =
+				static_cast<uint32_t>(m_releaseImageBarriers.size()),
+			.pImageMemoryBarriers = m_releaseImageBarriers.data(),
+		};
+
+		vkCmdPipelineBarrier2(command.getHandle(), &releaseInfo);
+	}
+
+	command.end();
+	m_isRecording = false;
+
+	const Command* commands[]{&command};
+
+	SemaphoreSubmit signalInfo{};
+
+	if (signalSemaphore != nullptr) {
+		signalInfo.semaphore = signalSemaphore->getHandle();
+	}
+
+	SubmitInfo const submitInfo{
+		.commands = commands,
+		.signalSemaphores = {&signalInfo, signalSemaphore != nullptr ? 1u : 0u},
+	};
+
+	const uint64_t value = m_device.submitCommands({&submitInfo, 1});
+
+	m_lastSubmittedValue = value;
+	m_batches[m_currentBatch].value = value;
+	m_currentBatch = (m_currentBatch + 1) % static_cast<uint32_t>(m_batches.size());
+
+	// the acquire side mirrors the release, with the destination scope filled in
+	if (m_srcFamilyIndex != m_dstFamilyIndex) {
+		for (auto barrier : m_releaseBufferBarriers) {
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+			barrier.srcAccessMask = VK_ACCESS_2_NONE;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			barrier.dstAccessMask =
+				VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+			m_acquireBufferBarriers.push_back(barrier);
+		}
+
+		for (auto barrier : m_releaseImageBarriers) {
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+			barrier.srcAccessMask = VK_ACCESS_2_NONE;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			barrier.dstAccessMask =
+				VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+			m_acquireImageBarriers.push_back(barrier);
+		}
+	}
+
+	m_releaseBufferBarriers.clear();
+	m_releaseImageBarriers.clear();
+
+	return value;
+}
+
+void UploadQueue::acquireOwnership(Command& command) {
+	if (m_acquireBufferBarriers.empty() && m_acquireImageBarriers.empty()) {
+		return;
+	}
+
+	assert(m_device.getQueueFamilyIndex(command.getQueue()) == m_dstFamilyIndex &&
+		   "Ownership can only be acquired on a graphics command");
+
+	VkDependencyInfo const acquireInfo{
+		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		.bufferMemoryBarrierCount =
+			static_cast<uint32_t>(m_acquireBufferBarriers.size()),
+		.pBufferMemoryBarriers = m_acquireBufferBarriers.data(),
+		.imageMemoryBarrierCount =
+			static_cast<uint32_t>(m_acquireImageBarriers.size()),
+		.pImageMemoryBarriers = m_acquireImageBarriers.data(),
+	};
+
+	vkCmdPipelineBarrier2(command.getHandle(), &acquireInfo);
+
+	m_acquireBufferBarriers.clear();
+	m_acquireImageBarriers.clear();
+}
+
+bool UploadQueue::isComplete(uint64_t value) const {
+	return getCompletedValue() >= value;
+}
+
+void UploadQueue::wait(uint64_t value) const {
+	m_device.waitForValue(m_queue, value);
+}
+
+uint64_t UploadQueue::getCompletedValue() const {
+	return m_device.getCompletedValue(m_queue);
+}
+
+const TimelineSemaphore& UploadQueue::getTimelineSemaphore() const {
+	return m_device.getQueueTimeline(m_queue);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vulkan/vulkan_core.h>
+#include <functional>
 
 namespace ignis {
 
@@ -19,4 +20,9 @@ bool isColorFormat(VkFormat);
 
 bool isDepthFormat(VkFormat);
 
+template <typename T>
+inline void hashCombine(size_t& seed, const T& value) {
+	seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
 }  // namespace ignis